@@ -19,6 +19,7 @@
 
 #include "../../Constants.h"
 #include "../../Data/WeaponData.h"
+#include "../../Graphics/GraphicsGL.h"
 
 #include <array>
 
@@ -28,6 +29,10 @@ CharLook::CharLook(const LookEntry& entry)
 {
     reset();
 
+    body = nullptr;
+    hair = nullptr;
+    face = nullptr;
+    look_hash = 0;
     set_body(entry.skin);
     set_hair(entry.hair_id);
     set_face(entry.face_id);
@@ -44,6 +49,7 @@ CharLook::CharLook()
     body = nullptr;
     hair = nullptr;
     face = nullptr;
+    look_hash = 0;
 }
 
 void CharLook::reset()
@@ -376,11 +382,44 @@ void CharLook::draw(const DrawArgument& args, float alpha) const
         break;
     }
 
-    draw(rel_args + args,
+    DrawArgument look_args = rel_args + args;
+
+    // Only looks which are drawn at their own size are composited, as the
+    // composite would be scaled otherwise.
+    if (args.get_xscale() != 1.0f || args.get_yscale() != 1.0f
+        || args.getstretch() != Point<std::int16_t>{}
+        || args.get_angle() != 0.0f) {
+        draw(look_args,
+             inter_stance,
+             inter_expression,
+             inter_frame,
+             inter_exp_frame);
+        return;
+    }
+
+    // Each part of the pose gets a byte of its own.
+    auto expression = static_cast<std::uint8_t>(inter_expression);
+    std::uint64_t pose = std::uint64_t{inter_stance} << 32
+                         | std::uint64_t{expression} << 24
+                         | std::uint64_t{inter_frame} << 16
+                         | std::uint64_t{inter_exp_frame} << 8
+                         | std::uint64_t{flip};
+    GraphicsGL::CompositeKey key{look_hash, pose};
+    Point<std::int16_t> pos = look_args.getpos();
+    const Color& color = args.get_color();
+
+    GraphicsGL& graphics = GraphicsGL::get();
+    if (graphics.draw_composite(key, pos, color)) {
+        return;
+    }
+
+    graphics.begin_composite();
+    draw(look_args,
          inter_stance,
          inter_expression,
          inter_frame,
          inter_exp_frame);
+    graphics.end_composite(key, pos, color);
 }
 
 void CharLook::draw(Point<std::int16_t> position,
@@ -492,6 +531,7 @@ void CharLook::set_body(std::int32_t skin_id)
                    .first;
     }
     body = &iter->second;
+    update_look_hash();
 }
 
 void CharLook::set_hair(std::int32_t hair_id)
@@ -505,6 +545,7 @@ void CharLook::set_hair(std::int32_t hair_id)
                    .first;
     }
     hair = &iter->second;
+    update_look_hash();
 }
 
 void CharLook::set_face(std::int32_t face_id)
@@ -514,6 +555,7 @@ void CharLook::set_face(std::int32_t face_id)
         iter = face_types.emplace(face_id, face_id).first;
     }
     face = &iter->second;
+    update_look_hash();
 }
 
 void CharLook::update_two_handed()
@@ -526,6 +568,7 @@ void CharLook::add_equip(std::int32_t item_id)
 {
     equips.add_equip(item_id, draw_info);
     update_two_handed();
+    update_look_hash();
 }
 
 void CharLook::remove_equip(Equipslot::Id slot)
@@ -534,6 +577,29 @@ void CharLook::remove_equip(Equipslot::Id slot)
     if (slot == Equipslot::WEAPON) {
         update_two_handed();
     }
+    update_look_hash();
+}
+
+void CharLook::update_look_hash()
+{
+    // FNV-1a over the parts, which live in static maps and so keep their
+    // addresses, and the equipped items.
+    std::uint64_t hash = 0xCBF29CE484222325;
+    auto combine = [&](std::uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (value >> (i * 8)) & 0xFF;
+            hash *= 0x100000001B3;
+        }
+    };
+
+    combine(reinterpret_cast<std::uintptr_t>(body));
+    combine(reinterpret_cast<std::uintptr_t>(hair));
+    combine(reinterpret_cast<std::uintptr_t>(face));
+    for (Equipslot::Id slot : Equipslot::values) {
+        combine(static_cast<std::uint32_t>(equips.get_equip(slot)));
+    }
+
+    look_hash = hash;
 }
 
 void CharLook::attack(bool degenerate)
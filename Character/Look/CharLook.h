@@ -79,6 +79,9 @@ private:
               std::uint8_t inter_exp_frame) const;
     std::uint16_t get_delay(Stance::Id stance, std::uint8_t frame) const;
     std::uint8_t get_next_frame(Stance::Id stance, std::uint8_t frame) const;
+    //! Recompute the hash of the look after it changed, and drop the
+    //! composites of the old look.
+    void update_look_hash();
     Stance::Id get_attack_stance(std::uint8_t attack, bool degenerate) const;
 
     Nominal<Stance::Id> stance;
@@ -99,6 +102,8 @@ private:
     const Hair* hair;
     const Face* face;
     CharEquips equips;
+    //! Identifies the body, hair, face and equips in the composite cache.
+    std::uint64_t look_hash;
 
     TimedBool alerted;
 
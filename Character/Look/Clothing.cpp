@@ -19,6 +19,7 @@
 
 #include "../../Data/EquipData.h"
 #include "../../Data/WeaponData.h"
+#include "../../Util/Profiler.h"
 #include "nlnx/node.hpp"
 #include "nlnx/nx.hpp"
 
@@ -31,6 +32,8 @@ using namespace std::string_literals;
 
 Clothing::Clothing(std::int32_t id, const BodyDrawinfo& drawinfo) : item_id(id)
 {
+    Profiler::Scope scope{"Clothing::Clothing"};
+
     const EquipData& equipdata = EquipData::get(item_id);
 
     equip_slot = equipdata.get_eq_slot();
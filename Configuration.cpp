@@ -94,6 +94,25 @@ void Configuration::load() noexcept(false)
                 "using default.");
         }
 
+        if (auto max_fps = video_table->get_as<std::uint16_t>("max_fps");
+            max_fps) {
+            video.max_fps = *max_fps;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.max_fps\" found; "
+                "using default.");
+        }
+
+        if (auto background_fps
+            = video_table->get_as<std::uint16_t>("background_fps");
+            background_fps) {
+            video.background_fps = *background_fps;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.background_fps\" "
+                "found; using default.");
+        }
+
         if (auto low_quality = video_table->get_as<bool>("low_quality");
             low_quality) {
             video.low_quality = *low_quality;
@@ -102,6 +121,75 @@ void Configuration::load() noexcept(false)
                 "No valid value for \"settings.toml:video.low_quality\" "
                 "found; using default.");
         }
+
+        if (auto core_profile = video_table->get_as<bool>("core_profile");
+            core_profile) {
+            video.core_profile = *core_profile;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.core_profile\" "
+                "found; using default.");
+        }
+
+        if (auto atlas_pages
+            = video_table->get_as<std::uint8_t>("atlas_pages");
+            atlas_pages) {
+            video.atlas_pages = *atlas_pages;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.atlas_pages\" "
+                "found; using default.");
+        }
+
+        if (auto upload_budget_kb
+            = video_table->get_as<std::uint32_t>("upload_budget_kb");
+            upload_budget_kb) {
+            video.upload_budget_kb = *upload_budget_kb;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.upload_budget_kb\" "
+                "found; using default.");
+        }
+
+        if (auto upload_budget_ms
+            = video_table->get_as<std::uint8_t>("upload_budget_ms");
+            upload_budget_ms) {
+            video.upload_budget_ms = *upload_budget_ms;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.upload_budget_ms\" "
+                "found; using default.");
+        }
+
+        if (auto composite_cache
+            = video_table->get_as<std::uint16_t>("composite_cache");
+            composite_cache) {
+            video.composite_cache = *composite_cache;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.composite_cache\" "
+                "found; using default.");
+        }
+
+        if (auto render_thread = video_table->get_as<bool>("render_thread");
+            render_thread) {
+            video.render_thread = *render_thread;
+        } else {
+            Console::get().print(
+                "No valid value for \"settings.toml:video.render_thread\" "
+                "found; using default.");
+        }
+
+        if (auto hitch_threshold_ms
+            = video_table->get_as<std::uint16_t>("hitch_threshold_ms");
+            hitch_threshold_ms) {
+            video.hitch_threshold_ms = *hitch_threshold_ms;
+        } else {
+            Console::get().print(
+                "No valid value for "
+                "\"settings.toml:video.hitch_threshold_ms\" found; using "
+                "default.");
+        }
     } else {
         Console::get().print(
             "No valid table \"settings.toml:video\" found; using default.");
@@ -715,7 +803,16 @@ port = $
 [video]
 fullscreen = $
 vsync = $
+max_fps = $  # Zero means no limit.
+background_fps = $  # Used while the window is not focused.
 low_quality = $
+core_profile = $
+atlas_pages = $
+upload_budget_kb = $
+upload_budget_ms = $
+composite_cache = $
+render_thread = $
+hitch_threshold_ms = $  # Slower frames are logged. Zero disables.
 
 [fonts]
 normal = $
@@ -804,75 +901,102 @@ simple_minimap = $
                 write(video.vsync);
                 break;
             case 4:
-                write(video.low_quality);
+                write(video.max_fps);
                 break;
             case 5:
-                write(fonts.normal);
+                write(video.background_fps);
                 break;
             case 6:
-                write(fonts.bold);
+                write(video.low_quality);
                 break;
             case 7:
-                write(audio.sound_effects);
+                write(video.core_profile);
                 break;
             case 8:
-                write(audio.music);
+                write(video.atlas_pages);
                 break;
             case 9:
-                write(audio.volume.sound_effects);
+                write(video.upload_budget_kb);
                 break;
             case 10:
-                write(audio.volume.music);
+                write(video.upload_budget_ms);
                 break;
             case 11:
-                write(account.save_login);
+                write(video.composite_cache);
                 break;
             case 12:
-                write(account.account_name);
+                write(video.render_thread);
                 break;
             case 13:
-                write(account.world);
+                write(video.hitch_threshold_ms);
                 break;
             case 14:
-                write(account.channel);
+                write(fonts.normal);
                 break;
             case 15:
-                write(account.character);
+                write(fonts.bold);
                 break;
             case 16:
-                write(ui.hp_alert);
+                write(audio.sound_effects);
                 break;
             case 17:
-                write(ui.mp_alert);
+                write(audio.music);
                 break;
             case 18:
-                write(ui.shake_screen);
+                write(audio.volume.sound_effects);
                 break;
             case 19:
-                write(ui.simple_minimap);
+                write(audio.volume.music);
                 break;
             case 20:
-                write(ui.position.key_config);
+                write(account.save_login);
                 break;
             case 21:
-                write(ui.position.stats);
+                write(account.account_name);
                 break;
             case 22:
-                write(ui.position.inventory);
+                write(account.world);
                 break;
             case 23:
-                write(ui.position.equip_inventory);
+                write(account.channel);
                 break;
             case 24:
-                write(ui.position.skillbook);
+                write(account.character);
                 break;
             case 25:
-                write(ui.position.change_channel);
+                write(ui.hp_alert);
                 break;
             case 26:
-                write(ui.position.game_settings);
+                write(ui.mp_alert);
                 break;
             case 27:
+                write(ui.shake_screen);
+                break;
+            case 28:
+                write(ui.simple_minimap);
+                break;
+            case 29:
+                write(ui.position.key_config);
+                break;
+            case 30:
+                write(ui.position.stats);
+                break;
+            case 31:
+                write(ui.position.inventory);
+                break;
+            case 32:
+                write(ui.position.equip_inventory);
+                break;
+            case 33:
+                write(ui.position.skillbook);
+                break;
+            case 34:
+                write(ui.position.change_channel);
+                break;
+            case 35:
+                write(ui.position.game_settings);
+                break;
+            case 36:
                 write(ui.position.system_settings);
                 break;
             default:
@@ -74,7 +74,16 @@ struct Configuration : public Singleton<Configuration> {
     struct Video {
         bool fullscreen = false;
         bool vsync = true;
+        std::uint16_t max_fps = 144;
+        std::uint16_t background_fps = 30;
         bool low_quality = false;
+        bool core_profile = true;
+        std::uint8_t atlas_pages = 1;
+        std::uint32_t upload_budget_kb = 4096;
+        std::uint8_t upload_budget_ms = 2;
+        std::uint16_t composite_cache = 512;
+        bool render_thread = true;
+        std::uint16_t hitch_threshold_ms = 33;
     };
 
     struct Fonts {
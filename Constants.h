@@ -25,6 +25,9 @@ namespace Constants
 //! Timestep, e.g. the granularity in which the game advances.
 constexpr std::uint16_t TIMESTEP = 8;
 
+//! The most timesteps the game catches up on at once, e.g. after a stall.
+constexpr std::uint16_t MAX_CATCHUP = 25;
+
 //! Initial window and screen width.
 constexpr std::int16_t VIEW_WIDTH = 800;
 
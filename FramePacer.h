@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "Template/Singleton.h"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace jrc
+{
+//! Limits the frame rate by waiting until the next frame is due.
+//!
+//! Sleeping is only precise to a millisecond or so, and much worse on some
+//! systems, so waits sleep until shortly before the deadline and spin for
+//! the rest.
+class FramePacer : public Singleton<FramePacer>
+{
+public:
+    FramePacer() noexcept : period{clock::duration::zero()}
+    {
+        start();
+    }
+
+    //! Start counting frames from now.
+    void start() noexcept
+    {
+        next = clock::now();
+    }
+
+    //! Set the target frame rate. Zero means no limit.
+    void set_rate(std::uint16_t fps) noexcept
+    {
+        clock::duration new_period
+            = fps ? std::chrono::duration_cast<clock::duration>(
+                        std::chrono::seconds{1})
+                        / fps
+                  : clock::duration::zero();
+        if (new_period != period) {
+            period = new_period;
+            start();
+        }
+    }
+
+    //! Wait until the next frame is due. Returns how long was waited.
+    std::chrono::steady_clock::duration wait() noexcept
+    {
+        if (period == clock::duration::zero()) {
+            return clock::duration::zero();
+        }
+
+        next += period;
+
+        // After falling behind, start over instead of rushing through the
+        // missed frames.
+        clock::time_point now = clock::now();
+        if (next < now) {
+            next = now;
+            return clock::duration::zero();
+        }
+
+        if (next - now > SPIN_TIME) {
+            std::this_thread::sleep_until(next - SPIN_TIME);
+        }
+        while (clock::now() < next) {
+            std::this_thread::yield();
+        }
+
+        return clock::now() - now;
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    //! How long before the deadline to stop sleeping.
+    static constexpr const std::chrono::microseconds SPIN_TIME{2000};
+
+    clock::duration period;
+    clock::time_point next;
+};
+} // namespace jrc
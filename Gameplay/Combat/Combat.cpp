@@ -20,6 +20,7 @@
 #include "../../Character/SkillId.h"
 #include "../../IO/Messages.h"
 #include "../../Net/Packets/AttackAndSkillPackets.h"
+#include "../../Util/Profiler.h"
 
 namespace jrc
 {
@@ -38,6 +39,8 @@ Combat::Combat(Player& in_player, MapChars& in_chars, MapMobs& in_mobs)
 
 void Combat::draw(double viewx, double viewy, float alpha) const
 {
+    Profiler::Scope scope{"Combat::draw"};
+
     for (auto& be : bullets) {
         be.bullet.draw(viewx, viewy, alpha);
     }
@@ -48,6 +51,8 @@ void Combat::draw(double viewx, double viewy, float alpha) const
 
 void Combat::update()
 {
+    Profiler::Scope scope{"Combat::update"};
+
     attack_results.update();
     bullet_effects.update();
     damage_effects.update();
@@ -19,6 +19,7 @@
 
 #include "../../Constants.h"
 #include "../../Graphics/GraphicsGL.h"
+#include "../../Util/Profiler.h"
 #include "nlnx/nx.hpp"
 
 namespace jrc
@@ -125,16 +126,11 @@ void Background::draw(double viewx, double viewy, float alpha) const
     auto ix = static_cast<std::int16_t>(std::round(x));
     auto iy = static_cast<std::int16_t>(std::round(y));
 
-    std::int16_t tw = cx * htile;
-    std::int16_t th = cy * vtile;
-    for (std::int16_t tx = 0; tx < tw; tx += cx) {
-        for (std::int16_t ty = 0; ty < th; ty += cy) {
-            animation.draw(DrawArgument(Point<std::int16_t>(ix + tx, iy + ty),
-                                        flipped,
-                                        opacity / 255),
-                           alpha);
-        }
-    }
+    animation.draw_tiled(
+        DrawArgument(Point<std::int16_t>(ix, iy), flipped, opacity / 255),
+        alpha,
+        {cx, cy},
+        {htile, vtile});
 }
 
 void Background::update()
@@ -168,6 +164,8 @@ void MapBackgrounds::drawbackgrounds(double viewx,
                                      double viewy,
                                      float alpha) const
 {
+    Profiler::Scope scope{"MapBackgrounds::drawbackgrounds"};
+
     if (black) {
         GraphicsGL::get().draw_screen_fill(0.0f, 0.0f, 0.0f, 1.0f);
     }
@@ -181,6 +179,8 @@ void MapBackgrounds::drawforegrounds(double viewx,
                                      double viewy,
                                      float alpha) const
 {
+    Profiler::Scope scope{"MapBackgrounds::drawforegrounds"};
+
     for (auto& foreground : foregrounds) {
         foreground.draw(viewx, viewy, alpha);
     }
@@ -188,6 +188,8 @@ void MapBackgrounds::drawforegrounds(double viewx,
 
 void MapBackgrounds::update()
 {
+    Profiler::Scope scope{"MapBackgrounds::update"};
+
     for (auto& background : backgrounds) {
         background.update();
     }
@@ -17,6 +17,8 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "MapChars.h"
 
+#include "../../Util/Profiler.h"
+
 namespace jrc
 {
 void MapChars::draw(Layer::Id layer,
@@ -24,11 +26,15 @@ void MapChars::draw(Layer::Id layer,
                     double viewy,
                     float alpha) const
 {
+    Profiler::Scope scope{"MapChars::draw"};
+
     chars.draw(layer, viewx, viewy, alpha);
 }
 
 void MapChars::update(const Physics& physics)
 {
+    Profiler::Scope scope{"MapChars::update"};
+
     for (; !spawns.empty(); spawns.pop()) {
         const CharSpawn& spawn = spawns.front();
 
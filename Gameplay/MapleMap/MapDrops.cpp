@@ -19,6 +19,7 @@
 
 #include "../../Constants.h"
 #include "../../Data/ItemData.h"
+#include "../../Util/Profiler.h"
 #include "Drop.h"
 #include "ItemDrop.h"
 #include "MesoDrop.h"
@@ -47,11 +48,15 @@ void MapDrops::draw(Layer::Id layer,
                     double viewy,
                     float alpha) const
 {
+    Profiler::Scope scope{"MapDrops::draw"};
+
     drops.draw(layer, viewx, viewy, alpha);
 }
 
 void MapDrops::update(const Physics& physics)
 {
+    Profiler::Scope scope{"MapDrops::update"};
+
     for (; !spawns.empty(); spawns.pop()) {
         const DropSpawn& spawn = spawns.front();
 
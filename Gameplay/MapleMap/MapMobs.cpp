@@ -17,6 +17,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "MapMobs.h"
 
+#include "../../Util/Profiler.h"
 #include "Mob.h"
 
 #include <algorithm>
@@ -30,11 +31,15 @@ void MapMobs::draw(Layer::Id layer,
                    double viewy,
                    float alpha) const
 {
+    Profiler::Scope scope{"MapMobs::draw"};
+
     mobs.draw(layer, viewx, viewy, alpha);
 }
 
 void MapMobs::update(const Physics& physics)
 {
+    Profiler::Scope scope{"MapMobs::update"};
+
     for (; !spawns.empty(); spawns.pop()) {
         const MobSpawn& spawn = spawns.front();
 
@@ -18,6 +18,7 @@
 #include "MapNpcs.h"
 
 #include "../../Net/Packets/NpcInteractionPackets.h"
+#include "../../Util/Profiler.h"
 #include "Npc.h"
 
 namespace jrc
@@ -27,11 +28,15 @@ void MapNpcs::draw(Layer::Id layer,
                    double viewy,
                    float alpha) const
 {
+    Profiler::Scope scope{"MapNpcs::draw"};
+
     npcs.draw(layer, viewx, viewy, alpha);
 }
 
 void MapNpcs::update(const Physics& physics)
 {
+    Profiler::Scope scope{"MapNpcs::update"};
+
     for (; !spawns.empty(); spawns.pop()) {
         const NpcSpawn& spawn = spawns.front();
 
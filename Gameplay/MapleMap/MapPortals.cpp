@@ -19,6 +19,7 @@
 
 #include "../../Constants.h"
 #include "../../Util/Misc.h"
+#include "../../Util/Profiler.h"
 #include "nlnx/nx.hpp"
 
 namespace jrc
@@ -63,6 +64,8 @@ MapPortals::MapPortals()
 
 void MapPortals::update(Point<std::int16_t> playerpos)
 {
+    Profiler::Scope scope{"MapPortals::update"};
+
     animations[Portal::REGULAR].update(Constants::TIMESTEP);
     animations[Portal::HIDDEN].update(Constants::TIMESTEP);
 
@@ -85,6 +88,8 @@ void MapPortals::update(Point<std::int16_t> playerpos)
 
 void MapPortals::draw(Point<std::int16_t> viewpos, float inter) const
 {
+    Profiler::Scope scope{"MapPortals::draw"};
+
     for (auto& pt_it : portals_by_id) {
         pt_it.second.draw(viewpos, inter);
     }
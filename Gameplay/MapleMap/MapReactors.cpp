@@ -17,6 +17,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "MapReactors.h"
 
+#include "../../Util/Profiler.h"
 #include "Reactor.h"
 
 namespace jrc
@@ -26,11 +27,15 @@ void MapReactors::draw(Layer::Id layer,
                        double viewy,
                        float alpha) const
 {
+    Profiler::Scope scope{"MapReactors::draw"};
+
     reactors.draw(layer, viewx, viewy, alpha);
 }
 
 void MapReactors::update(const Physics& physics)
 {
+    Profiler::Scope scope{"MapReactors::update"};
+
     for (; !spawns.empty(); spawns.pop()) {
         const ReactorSpawn& spawn = spawns.front();
 
@@ -17,16 +17,24 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "MapTilesObjs.h"
 
+#include "../../Graphics/GraphicsGL.h"
+#include "../../Util/Profiler.h"
+
 namespace jrc
 {
 TilesObjs::TilesObjs(nl::node src)
 {
     std::string tile_set = src["info"]["tS"];
     tile_set.append(".img", 4);
+    boost::container::flat_multimap<std::uint8_t, Tile> sorted;
     for (auto tile_node : src["tile"]) {
         Tile tile{tile_node, tile_set};
         std::int8_t z = tile.get_z();
-        tiles.emplace(z, std::move(tile));
+        sorted.emplace(z, std::move(tile));
+    }
+
+    for (auto& [_, tile] : sorted) {
+        tile.add_to(tiles);
     }
 
     for (auto obj_node : src["obj"]) {
@@ -34,6 +42,16 @@ TilesObjs::TilesObjs(nl::node src)
         std::int8_t z = obj.get_z();
         objs.emplace(z, std::move(obj));
     }
+
+    // Objs are indexed after sorting, so that visiting them in the order of
+    // their indices keeps them in order of depth.
+    obj_bounds.reserve(objs.size());
+    for (auto& [_, obj] : objs) {
+        auto index = static_cast<std::uint32_t>(obj_bounds.size());
+        obj_bounds.push_back(obj.get_bounds());
+        obj_grid.insert(index, obj_bounds.back());
+    }
+    obj_grid.build();
 }
 
 TilesObjs::TilesObjs() = default;
@@ -47,13 +65,26 @@ void TilesObjs::update()
 
 void TilesObjs::draw(Point<std::int16_t> view_pos, float alpha) const
 {
-    for (auto& [_, obj] : objs) {
-        obj.draw(view_pos, alpha);
-    }
+    Rectangle<std::int16_t> view = GraphicsGL::get_screen();
+    view.shift(-view_pos);
+
+    cull_stats = {};
+    for (std::uint32_t index : obj_grid.query(view)) {
+        ++cull_stats.visited;
+        if (!obj_bounds[index].overlaps(view)) {
+            continue;
+        }
 
-    for (auto& [_, tile] : tiles) {
-        tile.draw(view_pos);
+        ++cull_stats.drawn;
+        (objs.begin() + index)->second.draw(view_pos, alpha);
     }
+
+    tiles.draw(view_pos);
+}
+
+const CullStats& TilesObjs::get_cull_stats() const noexcept
+{
+    return cull_stats;
 }
 
 MapTilesObjs::MapTilesObjs(nl::node src)
@@ -69,13 +100,28 @@ void MapTilesObjs::draw(Layer::Id layer,
                         Point<std::int16_t> view_pos,
                         float alpha) const
 {
+    Profiler::Scope scope{"MapTilesObjs::draw"};
+
     layers[layer].draw(view_pos, alpha);
 }
 
 void MapTilesObjs::update()
 {
+    Profiler::Scope scope{"MapTilesObjs::update"};
+
     for (auto iter : layers) {
         iter.second.update();
     }
 }
+
+CullStats MapTilesObjs::get_cull_stats() const noexcept
+{
+    CullStats total;
+    for (auto iter : layers) {
+        total.visited += iter.second.get_cull_stats().visited;
+        total.drawn += iter.second.get_cull_stats().drawn;
+    }
+
+    return total;
+}
 } // namespace jrc
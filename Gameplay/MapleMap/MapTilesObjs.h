@@ -16,7 +16,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
+#include "../../Graphics/StaticBatch.h"
 #include "../../Template/EnumMap.h"
+#include "../../Template/UniformGrid.h"
 #include "Layer.h"
 #include "Obj.h"
 #include "Tile.h"
@@ -26,6 +28,14 @@
 
 namespace jrc
 {
+//! Counters for the objs visited while drawing.
+struct CullStats {
+    //! Objs in cells which overlap the screen.
+    std::size_t visited = 0;
+    //! Visited objs which overlap the screen themselves.
+    std::size_t drawn = 0;
+};
+
 //! A tile and obj layer.
 class TilesObjs
 {
@@ -36,9 +46,19 @@ public:
     void draw(Point<std::int16_t> view_pos, float alpha) const;
     void update();
 
+    //! Return the counters of the last draw.
+    const CullStats& get_cull_stats() const noexcept;
+
 private:
-    boost::container::flat_multimap<std::uint8_t, Tile> tiles;
+    //! Tiles never move, so they are drawn from one static batch, in order
+    //! of depth.
+    StaticBatch tiles;
     boost::container::flat_multimap<std::uint8_t, Obj> objs;
+    //! Positions of the objs in `objs`, so that only those near the screen
+    //! are visited.
+    UniformGrid obj_grid;
+    std::vector<Rectangle<std::int16_t>> obj_bounds;
+    mutable CullStats cull_stats;
 };
 
 //! The collection of tile and obj layers on a map.
@@ -52,6 +72,9 @@ public:
     draw(Layer::Id layer, Point<std::int16_t> view_pos, float alpha) const;
     void update();
 
+    //! Return the counters of the last draw, summed over all layers.
+    CullStats get_cull_stats() const noexcept;
+
 private:
     EnumMap<Layer::Id, TilesObjs> layers;
 };
@@ -20,6 +20,7 @@
 #include "../../Constants.h"
 #include "../../Net/Packets/GameplayPackets.h"
 #include "../../Util/Misc.h"
+#include "../../Util/Profiler.h"
 #include "../Movement.h"
 #include "nlnx/nx.hpp"
 
@@ -38,6 +39,8 @@ Mob::Mob(std::int32_t oid,
          Point<std::int16_t> position)
     : MapObject(oid)
 {
+    Profiler::Scope scope{"Mob::Mob"};
+
     std::string strid = string_format::extend_id(mob_id, 7);
     const nl::node src = nl::nx::mob[strid + ".img"];
 
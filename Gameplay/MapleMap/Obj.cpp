@@ -41,6 +41,20 @@ void Obj::draw(Point<std::int16_t> view_pos, float inter) const
     animation.draw(DrawArgument{pos + view_pos, flip}, inter);
 }
 
+Rectangle<std::int16_t> Obj::get_bounds() const
+{
+    Rectangle<std::int16_t> extent = animation.get_extent();
+    if (flip) {
+        extent = {static_cast<std::int16_t>(-extent.r()),
+                  static_cast<std::int16_t>(-extent.l()),
+                  extent.t(),
+                  extent.b()};
+    }
+
+    extent.shift(pos);
+    return extent;
+}
+
 std::uint8_t Obj::get_z() const noexcept
 {
     return z;
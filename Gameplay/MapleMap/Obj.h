@@ -31,6 +31,8 @@ public:
     void update();
     //! Draw the obj at the specified position.
     void draw(Point<std::int16_t> view_pos, float inter) const;
+    //! Return the area the obj can cover in any frame, in map coordinates.
+    Rectangle<std::int16_t> get_bounds() const;
     //! Return depth of the obj.
     std::uint8_t get_z() const noexcept;
 
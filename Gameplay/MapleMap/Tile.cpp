@@ -37,6 +37,11 @@ void Tile::draw(Point<std::int16_t> viewpos) const
     texture.draw(pos + viewpos);
 }
 
+void Tile::add_to(StaticBatch& batch) const
+{
+    texture.add_to(batch, pos);
+}
+
 std::uint8_t Tile::get_z() const
 {
     return z;
@@ -34,6 +34,8 @@ public:
 
     //! Draw the tile.
     void draw(Point<std::int16_t> viewpos) const;
+    //! Add the tile to a static batch which is drawn at the view position.
+    void add_to(StaticBatch& batch) const;
     //! Returns depth of the tile.
     std::uint8_t get_z() const;
 
@@ -23,6 +23,7 @@
 #include "../Net/Packets/AttackAndSkillPackets.h"
 #include "../Net/Packets/GameplayPackets.h"
 #include "../Util/Misc.h"
+#include "../Util/Profiler.h"
 #include "nlnx/nx.hpp"
 
 #include <iostream>
@@ -32,6 +33,7 @@ namespace jrc
 Stage::Stage() : combat(player, chars, mobs)
 {
     state = INACTIVE;
+    current_map = -1;
 }
 
 void Stage::init()
@@ -75,6 +77,10 @@ void Stage::clear()
 
 void Stage::load_map(std::int32_t map_id)
 {
+    Profiler::Scope scope{"Stage::load_map"};
+
+    current_map = map_id;
+
     std::string str_id = string_format::extend_id(map_id, 9);
     str_id += ".img";
 
@@ -108,6 +114,8 @@ void Stage::respawn(std::int8_t portal_id)
 
 void Stage::draw(float alpha) const
 {
+    Profiler::Scope scope{"Stage::draw"};
+
     if (state != ACTIVE) {
         return;
     }
@@ -134,6 +142,8 @@ void Stage::draw(float alpha) const
 
 void Stage::update()
 {
+    Profiler::Scope scope{"Stage::update"};
+
     if (state != ACTIVE) {
         return;
     }
@@ -350,4 +360,9 @@ void Stage::set_channel_count(std::uint8_t ch_count) noexcept
 {
     channel_count = ch_count;
 }
+
+std::int32_t Stage::get_map_id() const noexcept
+{
+    return current_map;
+}
 } // namespace jrc
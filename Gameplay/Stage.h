@@ -100,6 +100,9 @@ public:
     //! Setter for the number of channels in the current world.
     void set_channel_count(std::uint8_t ch_count) noexcept;
 
+    //! Getter for the ID of the loaded map, or -1 if there is none.
+    [[nodiscard]] std::int32_t get_map_id() const noexcept;
+
 private:
     void load_map(std::int32_t map_id);
     void respawn(std::int8_t portal_id);
@@ -129,6 +132,7 @@ private:
     Combat combat;
 
     State state;
+    std::int32_t current_map;
     std::uint8_t world;
     std::uint8_t channel;
     std::uint8_t channel_count;
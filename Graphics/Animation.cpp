@@ -20,6 +20,9 @@
 #include "../Constants.h"
 #include "../Util/Misc.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace jrc
 {
 Frame::Frame(nl::node src) : texture{src}, bounds{src}
@@ -68,6 +71,13 @@ void Frame::draw(const DrawArgument& args) const
     texture.draw(args);
 }
 
+void Frame::draw_tiled(const DrawArgument& args,
+                       Point<std::int16_t> period,
+                       Point<std::int16_t> count) const
+{
+    texture.draw_tiled(args, period, count);
+}
+
 std::uint8_t Frame::start_opacity() const
 {
     return opacities.first;
@@ -200,6 +210,27 @@ void Animation::draw(const DrawArgument& args, float alpha) const
     }
 }
 
+void Animation::draw_tiled(const DrawArgument& args,
+                           float alpha,
+                           Point<std::int16_t> period,
+                           Point<std::int16_t> count) const
+{
+    std::int16_t interframe = frame.get(alpha);
+    float inter_opc = opacity.get(alpha) / 255.0f;
+    float inter_scale = xy_scale.get(alpha) / 100.0f;
+
+    bool modify_opc = inter_opc != 1.0f;
+    bool modify_scale = inter_scale != 1.0f;
+    if (modify_opc || modify_scale) {
+        frames[interframe].draw_tiled(
+            args + DrawArgument{inter_scale, inter_scale, inter_opc},
+            period,
+            count);
+    } else {
+        frames[interframe].draw_tiled(args, period, count);
+    }
+}
+
 bool Animation::update()
 {
     return update(Constants::TIMESTEP);
@@ -320,6 +351,30 @@ Rectangle<std::int16_t> Animation::get_bounds() const
     return get_frame().get_bounds();
 }
 
+Rectangle<std::int16_t> Animation::get_extent() const
+{
+    float l = 0.0f;
+    float r = 0.0f;
+    float t = 0.0f;
+    float b = 0.0f;
+    for (const Frame& fr : frames) {
+        // Frames are scaled around the position they are drawn at.
+        float scale = std::max(fr.start_scale(), fr.end_scale()) / 100.0f;
+        Point<std::int16_t> origin = fr.get_origin();
+        Point<std::int16_t> dimensions = fr.get_dimensions();
+
+        l = std::min(l, -origin.x() * scale);
+        r = std::max(r, (dimensions.x() - origin.x()) * scale);
+        t = std::min(t, -origin.y() * scale);
+        b = std::max(b, (dimensions.y() - origin.y()) * scale);
+    }
+
+    return {static_cast<std::int16_t>(std::floor(l)),
+            static_cast<std::int16_t>(std::ceil(r)),
+            static_cast<std::int16_t>(std::floor(t)),
+            static_cast<std::int16_t>(std::ceil(b))};
+}
+
 const Frame& Animation::get_frame() const
 {
     return frames[frame.get()];
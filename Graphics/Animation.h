@@ -33,6 +33,9 @@ public:
     Frame() noexcept;
 
     void draw(const DrawArgument& args) const;
+    void draw_tiled(const DrawArgument& args,
+                    Point<std::int16_t> period,
+                    Point<std::int16_t> count) const;
 
     std::uint8_t start_opacity() const;
     std::uint8_t end_opacity() const;
@@ -67,6 +70,12 @@ public:
     void reset();
 
     void draw(const DrawArgument& arguments, float inter) const;
+    //! Draw the animation repeatedly, `count` times in each direction, with
+    //! the copies `period` pixels apart.
+    void draw_tiled(const DrawArgument& arguments,
+                    float inter,
+                    Point<std::int16_t> period,
+                    Point<std::int16_t> count) const;
 
     std::uint16_t get_delay(std::int16_t frame) const;
     std::uint16_t get_delay_until(std::int16_t frame) const;
@@ -74,6 +83,9 @@ public:
     Point<std::int16_t> get_dimensions() const;
     Point<std::int16_t> get_head() const;
     Rectangle<std::int16_t> get_bounds() const;
+    //! Return the smallest rectangle which contains every frame at its
+    //! largest scale, relative to the position the animation is drawn at.
+    Rectangle<std::int16_t> get_extent() const;
 
 private:
     const Frame& get_frame() const;
@@ -0,0 +1,32 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include <cstdint>
+
+namespace jrc
+{
+//! Refers to a bitmap in the texture atlas, so that it can be found again
+//! without hashing its id. The slot may be reused for another bitmap after
+//! eviction, in which case its generation no longer matches and the handle
+//! is refreshed on the next lookup.
+struct AtlasHandle {
+    std::uint32_t slot = 0;
+    //! Generations start at 1, so a default handle never matches.
+    std::uint32_t generation = 0;
+};
+} // namespace jrc
@@ -0,0 +1,288 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "AtlasPacker.h"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
+namespace jrc
+{
+AtlasPacker::AtlasPacker(std::int16_t w, std::int16_t h, std::int16_t min)
+    : width(w), height(h), min_size(min)
+{
+    reset(0);
+}
+
+bool AtlasPacker::BySize::operator()(const Space& a, const Space& b) const
+    noexcept
+{
+    return std::tie(a.h, a.w, a.y, a.x) < std::tie(b.h, b.w, b.y, b.x);
+}
+
+void AtlasPacker::reset(std::int16_t top)
+{
+    skyline.assign(1, {0, top, width});
+    spaces.clear();
+    by_top_left.clear();
+    by_top_right.clear();
+    by_bottom_left.clear();
+
+    allocated = 0;
+    unused = 0;
+}
+
+bool AtlasPacker::insert(std::int16_t w,
+                         std::int16_t h,
+                         Point<std::int16_t>& pos)
+{
+    if (w <= 0 || h <= 0 || w > width || h > height) {
+        return false;
+    }
+
+    if (insert_free(w, h, pos) || insert_skyline(w, h, pos)) {
+        allocated += static_cast<std::size_t>(w) * h;
+        return true;
+    }
+
+    return false;
+}
+
+void AtlasPacker::release(std::int16_t x,
+                          std::int16_t y,
+                          std::int16_t w,
+                          std::int16_t h)
+{
+    allocated -= static_cast<std::size_t>(w) * h;
+    add_space({x, y, w, h});
+}
+
+std::size_t AtlasPacker::allocated_area() const noexcept
+{
+    return allocated;
+}
+
+std::size_t AtlasPacker::free_area() const noexcept
+{
+    return unused;
+}
+
+double AtlasPacker::fill_ratio() const noexcept
+{
+    return static_cast<double>(allocated)
+           / (static_cast<double>(width) * height);
+}
+
+bool AtlasPacker::insert_free(std::int16_t w,
+                              std::int16_t h,
+                              Point<std::int16_t>& pos)
+{
+    constexpr auto lowest = std::numeric_limits<std::int16_t>::min();
+
+    // Spaces are ordered by height first, so everything before this one is
+    // too short, and the first wide enough space is the tightest fit.
+    auto iter = spaces.lower_bound({lowest, lowest, w, h});
+    while (iter != spaces.end() && iter->w < w) {
+        ++iter;
+    }
+
+    if (iter == spaces.end()) {
+        return false;
+    }
+
+    Space space = *iter;
+    remove_space(space);
+
+    pos = {space.x, space.y};
+
+    // Split along the shorter axis of what is left, which keeps the larger
+    // of the two remaining spaces as large as possible.
+    auto right = static_cast<std::int16_t>(space.x + w);
+    auto bottom = static_cast<std::int16_t>(space.y + h);
+    auto wdelta = static_cast<std::int16_t>(space.w - w);
+    auto hdelta = static_cast<std::int16_t>(space.h - h);
+    if (wdelta < hdelta) {
+        add_space({right, space.y, wdelta, h});
+        add_space({space.x, bottom, space.w, hdelta});
+    } else {
+        add_space({right, space.y, wdelta, space.h});
+        add_space({space.x, bottom, w, hdelta});
+    }
+
+    return true;
+}
+
+bool AtlasPacker::insert_skyline(std::int16_t w,
+                                 std::int16_t h,
+                                 Point<std::int16_t>& pos)
+{
+    std::size_t best = skyline.size();
+    std::int16_t best_y = 0;
+    std::int16_t best_bottom = std::numeric_limits<std::int16_t>::max();
+    std::int16_t best_width = 0;
+
+    for (std::size_t i = 0; i < skyline.size(); ++i) {
+        std::int16_t x = skyline[i].x;
+        if (x + w > width) {
+            break;
+        }
+
+        // The rectangle rests on the highest segment below it.
+        std::int16_t y = 0;
+        std::int16_t covered = 0;
+        for (std::size_t j = i; covered < w; ++j) {
+            y = std::max(y, skyline[j].y);
+            covered += skyline[j].w;
+        }
+
+        std::int16_t bottom = y + h;
+        if (bottom > height) {
+            continue;
+        }
+
+        if (bottom < best_bottom
+            || (bottom == best_bottom && skyline[i].w < best_width)) {
+            best = i;
+            best_y = y;
+            best_bottom = bottom;
+            best_width = skyline[i].w;
+        }
+    }
+
+    if (best == skyline.size()) {
+        return false;
+    }
+
+    std::int16_t x = skyline[best].x;
+    std::int16_t right = x + w;
+    pos = {x, best_y};
+
+    // Keep the gaps between the rectangle and the segments it covers.
+    for (std::size_t j = best; j < skyline.size() && skyline[j].x < right;
+         ++j) {
+        const Segment& segment = skyline[j];
+        std::int16_t gap_right = std::min<std::int16_t>(
+            right, segment.x + segment.w);
+        add_space({segment.x,
+                   segment.y,
+                   static_cast<std::int16_t>(gap_right - segment.x),
+                   static_cast<std::int16_t>(best_y - segment.y)});
+    }
+
+    skyline.insert(skyline.begin() + best, {x, best_bottom, w});
+    for (std::size_t j = best + 1; j < skyline.size();) {
+        Segment& segment = skyline[j];
+        if (segment.x >= right) {
+            break;
+        }
+
+        std::int16_t overlap = right - segment.x;
+        if (segment.w <= overlap) {
+            skyline.erase(skyline.begin() + j);
+        } else {
+            segment.x += overlap;
+            segment.w -= overlap;
+            break;
+        }
+    }
+
+    for (std::size_t j = 0; j + 1 < skyline.size();) {
+        if (skyline[j].y == skyline[j + 1].y) {
+            skyline[j].w += skyline[j + 1].w;
+            skyline.erase(skyline.begin() + j + 1);
+        } else {
+            ++j;
+        }
+    }
+
+    return true;
+}
+
+void AtlasPacker::add_space(Space space)
+{
+    if (space.w <= 0 || space.h <= 0) {
+        return;
+    }
+
+    // Grow the space for as long as it has a neighbour with a matching edge.
+    for (bool merged = true; merged;) {
+        merged = false;
+
+        auto below = by_top_left.find(corner(space.x, space.y + space.h));
+        if (below != by_top_left.end() && below->second.w == space.w) {
+            Space other = below->second;
+            remove_space(other);
+            space.h += other.h;
+            merged = true;
+        }
+
+        auto above = by_bottom_left.find(corner(space.x, space.y));
+        if (above != by_bottom_left.end() && above->second.w == space.w) {
+            Space other = above->second;
+            remove_space(other);
+            space.y = other.y;
+            space.h += other.h;
+            merged = true;
+        }
+
+        auto right = by_top_left.find(corner(space.x + space.w, space.y));
+        if (right != by_top_left.end() && right->second.h == space.h) {
+            Space other = right->second;
+            remove_space(other);
+            space.w += other.w;
+            merged = true;
+        }
+
+        auto left = by_top_right.find(corner(space.x, space.y));
+        if (left != by_top_right.end() && left->second.h == space.h) {
+            Space other = left->second;
+            remove_space(other);
+            space.x = other.x;
+            space.w += other.w;
+            merged = true;
+        }
+    }
+
+    if (space.w < min_size || space.h < min_size) {
+        return;
+    }
+
+    spaces.insert(space);
+    by_top_left.emplace(corner(space.x, space.y), space);
+    by_top_right.emplace(corner(space.x + space.w, space.y), space);
+    by_bottom_left.emplace(corner(space.x, space.y + space.h), space);
+
+    unused += static_cast<std::size_t>(space.w) * space.h;
+}
+
+void AtlasPacker::remove_space(const Space& space)
+{
+    spaces.erase(space);
+    by_top_left.erase(corner(space.x, space.y));
+    by_top_right.erase(corner(space.x + space.w, space.y));
+    by_bottom_left.erase(corner(space.x, space.y + space.h));
+
+    unused -= static_cast<std::size_t>(space.w) * space.h;
+}
+
+std::uint32_t AtlasPacker::corner(std::int16_t x, std::int16_t y) noexcept
+{
+    return static_cast<std::uint32_t>(static_cast<std::uint16_t>(x)) << 16
+           | static_cast<std::uint16_t>(y);
+}
+} // namespace jrc
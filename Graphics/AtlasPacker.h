@@ -0,0 +1,104 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../Template/Point.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace jrc
+{
+//! Packs rectangles into a fixed area, such as one page of the atlas.
+//!
+//! Fresh space is handed out from a skyline, putting every rectangle where
+//! its bottom edge ends up highest. Gaps which are left below the skyline,
+//! and rectangles which are released again, are kept as free spaces and are
+//! tried first. Free spaces are ordered by height, so the best fit is found
+//! without looking at any space which is too short, and they are merged with
+//! neighbours which share a whole edge.
+class AtlasPacker
+{
+public:
+    //! Create a packer for an area of `width` by `height`. Free spaces which
+    //! are narrower or shorter than `min_size` are not kept.
+    AtlasPacker(std::int16_t width,
+                std::int16_t height,
+                std::int16_t min_size);
+
+    //! Forget all rectangles, and keep the rows above `top` out of use.
+    void reset(std::int16_t top);
+    //! Find room for a rectangle of the given size. Returns `false` if there
+    //! is none.
+    bool insert(std::int16_t w, std::int16_t h, Point<std::int16_t>& pos);
+    //! Make the space of a rectangle which was inserted before available
+    //! again.
+    void
+    release(std::int16_t x, std::int16_t y, std::int16_t w, std::int16_t h);
+
+    //! Return the area covered by rectangles.
+    std::size_t allocated_area() const noexcept;
+    //! Return the area of all free spaces.
+    std::size_t free_area() const noexcept;
+    //! Return the fraction of the whole area covered by rectangles.
+    double fill_ratio() const noexcept;
+
+private:
+    struct Space {
+        std::int16_t x;
+        std::int16_t y;
+        std::int16_t w;
+        std::int16_t h;
+    };
+
+    struct BySize {
+        bool operator()(const Space& a, const Space& b) const noexcept;
+    };
+
+    struct Segment {
+        std::int16_t x;
+        std::int16_t y;
+        std::int16_t w;
+    };
+
+    bool insert_free(std::int16_t w, std::int16_t h, Point<std::int16_t>& pos);
+    bool
+    insert_skyline(std::int16_t w, std::int16_t h, Point<std::int16_t>& pos);
+    //! Keep track of a free space if it is large enough.
+    void add_space(Space space);
+    void remove_space(const Space& space);
+
+    static std::uint32_t corner(std::int16_t x, std::int16_t y) noexcept;
+
+    std::int16_t width;
+    std::int16_t height;
+    std::int16_t min_size;
+
+    std::vector<Segment> skyline;
+    std::set<Space, BySize> spaces;
+    // Free spaces never overlap, so each of their corners is unique.
+    std::unordered_map<std::uint32_t, Space> by_top_left;
+    std::unordered_map<std::uint32_t, Space> by_top_right;
+    std::unordered_map<std::uint32_t, Space> by_bottom_left;
+
+    std::size_t allocated;
+    std::size_t unused;
+};
+} // namespace jrc
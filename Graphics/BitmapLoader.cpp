@@ -0,0 +1,130 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "BitmapLoader.h"
+
+#include <cstring>
+#include <utility>
+
+namespace jrc
+{
+namespace
+{
+// nl::bitmap::data() decompresses into a buffer which is shared by all
+// bitmaps, so only one thread may call it and copy the result at a time.
+std::mutex decompress_mutex;
+} // namespace
+
+BitmapLoader::BitmapLoader() noexcept : busy{0}, stopping{false}
+{
+}
+
+BitmapLoader::~BitmapLoader()
+{
+    stop();
+}
+
+void BitmapLoader::start(std::size_t threads)
+{
+    stop();
+
+    stopping = false;
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&BitmapLoader::work, this);
+    }
+}
+
+void BitmapLoader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock{job_mutex};
+        stopping = true;
+        jobs.clear();
+    }
+    job_ready.notify_all();
+
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    std::lock_guard<std::mutex> lock{result_mutex};
+    results.clear();
+}
+
+void BitmapLoader::push(Job job)
+{
+    {
+        std::lock_guard<std::mutex> lock{job_mutex};
+        jobs.push_back(std::move(job));
+    }
+    job_ready.notify_one();
+}
+
+bool BitmapLoader::pop(Result& result)
+{
+    std::lock_guard<std::mutex> lock{result_mutex};
+    if (results.empty()) {
+        return false;
+    }
+
+    result = std::move(results.front());
+    results.pop_front();
+    return true;
+}
+
+std::size_t BitmapLoader::pending() const
+{
+    std::lock_guard<std::mutex> lock{job_mutex};
+    return jobs.size() + busy;
+}
+
+void BitmapLoader::work()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock{job_mutex};
+            job_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) {
+                return;
+            }
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            ++busy;
+        }
+
+        Result result{job.slot, job.generation, {}};
+        {
+            std::lock_guard<std::mutex> lock{decompress_mutex};
+            if (const void* data = job.bitmap.data(); data) {
+                auto bytes = static_cast<const std::uint8_t*>(data);
+                result.pixels.assign(bytes, bytes + job.bitmap.length());
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{result_mutex};
+            results.push_back(std::move(result));
+        }
+
+        std::lock_guard<std::mutex> lock{job_mutex};
+        --busy;
+    }
+}
+} // namespace jrc
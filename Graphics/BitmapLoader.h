@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "nlnx/bitmap.hpp"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jrc
+{
+//! Decompresses bitmaps on worker threads, so that loading a map does not
+//! stall the frame. Finished bitmaps are collected by the main thread, which
+//! uploads them to the atlas.
+class BitmapLoader
+{
+public:
+    //! A bitmap to decompress, and the atlas slot it is meant for.
+    struct Job {
+        nl::bitmap bitmap;
+        std::uint32_t slot;
+        std::uint32_t generation;
+    };
+
+    //! The pixels of a bitmap, in BGRA order. Empty if the bitmap has no
+    //! data.
+    struct Result {
+        std::uint32_t slot;
+        std::uint32_t generation;
+        std::vector<std::uint8_t> pixels;
+    };
+
+    BitmapLoader() noexcept;
+    ~BitmapLoader();
+
+    BitmapLoader(const BitmapLoader&) = delete;
+    BitmapLoader& operator=(const BitmapLoader&) = delete;
+
+    //! Start the worker threads.
+    void start(std::size_t threads);
+    //! Stop the worker threads, dropping all unfinished jobs.
+    void stop();
+
+    //! Queue a bitmap for decompression.
+    void push(Job job);
+    //! Take a finished bitmap, if there is one.
+    bool pop(Result& result);
+    //! Return the number of bitmaps which are queued or being decompressed.
+    std::size_t pending() const;
+
+private:
+    void work();
+
+    std::vector<std::thread> workers;
+
+    mutable std::mutex job_mutex;
+    std::condition_variable job_ready;
+    std::deque<Job> jobs;
+    std::size_t busy;
+    bool stopping;
+
+    std::mutex result_mutex;
+    std::deque<Result> results;
+};
+} // namespace jrc
@@ -112,6 +112,12 @@ public:
         return rgba[3];
     }
 
+    //! Return all components as natural numbers [0, 255].
+    constexpr std::array<std::uint8_t, LENGTH> to_bytes() const
+    {
+        return {{to_byte(r()), to_byte(g()), to_byte(b()), to_byte(a())}};
+    }
+
     //! Return all components.
     const float* data() const;
 
@@ -137,6 +143,17 @@ public:
     }
 
 private:
+    static constexpr std::uint8_t to_byte(float comp)
+    {
+        if (comp <= 0.0f) {
+            return 0;
+        } else if (comp >= 1.0f) {
+            return 255;
+        } else {
+            return static_cast<std::uint8_t>(comp * 255.0f + 0.5f);
+        }
+    }
+
     underlying_t rgba;
 };
 } // namespace jrc
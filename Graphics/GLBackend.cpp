@@ -0,0 +1,838 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "GLBackend.h"
+
+#include "../Configuration.h"
+#include "../IO/Window.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace jrc
+{
+GraphicsGL::GLBackend::GLBackend(StreamBuffer& s) noexcept
+    : stream{s},
+      core_profile{false},
+      ibo{0},
+      vao{0},
+      pbo{0},
+      pbo_offset{0},
+      resolve_program{0},
+      resolve_vao{0},
+      scratch_texture{0},
+      scratch_fbo{0},
+      atlas_fbo{0}
+{
+}
+
+Error GraphicsGL::GLBackend::init(GraphicsGL& gl, GLushort& page_count)
+{
+    glewExperimental = GL_TRUE;
+    if (glewInit()) {
+        return Error::GLEW;
+    }
+    // GLEW may query extensions in a way that core profiles reject.
+    glGetError();
+
+    core_profile
+        = Configuration::get().video.core_profile && GLEW_VERSION_3_3;
+
+    GLint result = GL_FALSE;
+
+    static constexpr const char* const vs_source_legacy
+        = "#version 120\n"
+          "attribute vec2 position;"
+          "attribute vec2 texcoord;"
+          "attribute vec4 color;"
+          "varying vec2 texpos;"
+          "varying vec4 colormod;"
+          "uniform vec2 screensize;"
+          "uniform int yoffset;"
+
+          "void main(void) {"
+          "    float x = -1.0 + position.x * 2.0 / screensize.x;"
+          "    float y = 1.0 - (position.y + yoffset) * 2.0 / screensize.y;"
+          "    gl_Position = vec4(x, y, 0.0, 1.0);"
+          "    texpos = texcoord;"
+          "    colormod = color;"
+          "}";
+    // Every quad is an instance. The corner is selected by the index, and
+    // rotation is applied to every corner, which is exact for an angle of 0.
+    static constexpr const char* const vs_source_core
+        = "#version 330 core\n"
+          "in vec4 rect;"
+          "in vec4 texrect;"
+          "in vec4 color;"
+          "in float angle;"
+          "in float page;"
+          "in vec2 period;"
+          "out vec2 texpos;"
+          "out vec4 colormod;"
+          "out vec2 local;"
+          "flat out float layer;"
+          "flat out vec4 tile;"
+          "flat out vec2 tileperiod;"
+          "uniform vec2 screensize;"
+          "uniform int yoffset;"
+          "uniform vec2 offset;"
+
+          "void main(void) {"
+          "    bool right = gl_VertexID == 2 || gl_VertexID == 3;"
+          "    bool bottom = gl_VertexID == 1 || gl_VertexID == 2;"
+          "    vec2 corner = vec2(right ? rect.y : rect.x,"
+          "                       bottom ? rect.w : rect.z);"
+          "    vec2 center = trunc(vec2(rect.x + rect.y, rect.z + rect.w)"
+          "                        / 2.0);"
+          "    vec2 d = corner - center;"
+          "    float c = cos(angle);"
+          "    float s = sin(angle);"
+          "    vec2 pos = center + floor(vec2(d.x * c - d.y * s,"
+          "                                   d.x * s + d.y * c) + 0.5)"
+          "               + offset;"
+          "    float x = -1.0 + pos.x * 2.0 / screensize.x;"
+          "    float y = 1.0 - (pos.y + yoffset) * 2.0 / screensize.y;"
+          "    gl_Position = vec4(x, y, 0.0, 1.0);"
+          "    texpos = vec2(right ? texrect.y : texrect.x,"
+          "                  bottom ? texrect.w : texrect.z);"
+          "    colormod = color;"
+          "    layer = page;"
+          "    local = corner - rect.xz;"
+          "    tile = texrect;"
+          "    tileperiod = period;"
+          "}";
+
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    const char* vs_source = core_profile ? vs_source_core : vs_source_legacy;
+    glShaderSource(vs, 1, &vs_source, NULL);
+    glCompileShader(vs);
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &result);
+    if (!result) {
+        return Error::VERTEX_SHADER;
+    }
+
+    static constexpr const char* const fs_source_legacy
+        = "#version 120\n"
+          "varying vec2 texpos;"
+          "varying vec4 colormod;"
+          "uniform sampler2D atlas;"
+          "uniform vec2 atlassize;"
+          "uniform int fontregion;"
+          "uniform int page;"
+          "uniform float opacity;"
+
+          "void main(void) {"
+          "    if (texpos.y == 0) {"
+          "        gl_FragColor = colormod;"
+          "    } else if (page == 0 && texpos.y <= fontregion) {"
+          "        gl_FragColor = vec4(1, 1, 1, texture2D(atlas, texpos / "
+          "atlassize).r) * colormod;"
+          "    } else {"
+          "        gl_FragColor = texture2D(atlas, texpos / atlassize) * "
+          "colormod;"
+          "    }"
+          "    gl_FragColor.rgb *= opacity;"
+          "}";
+    static constexpr const char* const fs_source_core
+        = "#version 330 core\n"
+          "in vec2 texpos;"
+          "in vec4 colormod;"
+          "in vec2 local;"
+          "flat in float layer;"
+          "flat in vec4 tile;"
+          "flat in vec2 tileperiod;"
+          "out vec4 fragcolor;"
+          "uniform sampler2DArray atlas;"
+          "uniform vec2 atlassize;"
+          "uniform int fontregion;"
+          "uniform float opacity;"
+          "uniform int composite;"
+
+          "void main(void) {"
+          "    vec4 tint = composite != 0 ? vec4(1.0) : colormod;"
+          "    vec2 pos = texpos;"
+          "    if (tileperiod.x > 0.0) {"
+          "        vec2 cell = mod(local, tileperiod);"
+          "        vec2 size = abs(tile.yw - tile.xz);"
+          "        if (cell.x >= size.x || cell.y >= size.y) {"
+          "            discard;"
+          "        }"
+          "        pos = mix(tile.xz, tile.yw, cell / size);"
+          "    }"
+          "    vec3 coord = vec3(pos / atlassize, layer);"
+          "    if (pos.y == 0) {"
+          "        fragcolor = tint;"
+          "    } else if (layer == 0 && pos.y <= fontregion) {"
+          "        fragcolor = vec4(1, 1, 1, texture(atlas, coord).r) * tint;"
+          "    } else {"
+          "        fragcolor = texture(atlas, coord) * tint;"
+          "    }"
+          "    fragcolor.rgb *= opacity;"
+          "    if (composite != 0) {"
+          "        fragcolor.rgb *= fragcolor.a;"
+          "    }"
+          "}";
+
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    const char* fs_source = core_profile ? fs_source_core : fs_source_legacy;
+    glShaderSource(fs, 1, &fs_source, NULL);
+    glCompileShader(fs);
+    glGetShaderiv(fs, GL_COMPILE_STATUS, &result);
+    if (!result) {
+        return Error::FRAGMENT_SHADER;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (!result) {
+        return Error::SHADER_PROGRAM;
+    }
+
+    attribute_color = glGetAttribLocation(program, "color");
+    uniform_texture = glGetUniformLocation(program, "atlas");
+    uniform_atlas_size = glGetUniformLocation(program, "atlassize");
+    uniform_screen_size = glGetUniformLocation(program, "screensize");
+    uniform_y_offset = glGetUniformLocation(program, "yoffset");
+    uniform_font_region = glGetUniformLocation(program, "fontregion");
+    uniform_opacity = glGetUniformLocation(program, "opacity");
+    if (attribute_color == -1 || uniform_texture == -1
+        || uniform_atlas_size == -1 || uniform_y_offset == -1
+        || uniform_screen_size == -1 || uniform_opacity == -1) {
+        return Error::SHADER_VARS;
+    }
+
+    if (core_profile) {
+        attribute_rect = glGetAttribLocation(program, "rect");
+        attribute_texrect = glGetAttribLocation(program, "texrect");
+        attribute_angle = glGetAttribLocation(program, "angle");
+        attribute_page = glGetAttribLocation(program, "page");
+        attribute_period = glGetAttribLocation(program, "period");
+        uniform_offset = glGetUniformLocation(program, "offset");
+        uniform_composite = glGetUniformLocation(program, "composite");
+        if (attribute_rect == -1 || attribute_texrect == -1
+            || attribute_angle == -1 || attribute_page == -1
+            || attribute_period == -1 || uniform_offset == -1
+            || uniform_composite == -1) {
+            return Error::SHADER_VARS;
+        }
+    } else {
+        attribute_position = glGetAttribLocation(program, "position");
+        attribute_texcoord = glGetAttribLocation(program, "texcoord");
+        uniform_page = glGetUniformLocation(program, "page");
+        if (attribute_position == -1 || attribute_texcoord == -1
+            || uniform_page == -1) {
+            return Error::SHADER_VARS;
+        }
+    }
+
+    gl.core_profile = core_profile;
+    if (core_profile) {
+        stream.init(sizeof(Quad), MAX_QUADS);
+
+        // Every quad is drawn as one instance of the same two triangles, so
+        // the index buffer never changes.
+        static constexpr const GLuint indices[INDICES_PER_QUAD]
+            = {0, 1, 2, 2, 3, 0};
+
+        glGenBuffers(1, &ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                     sizeof(indices),
+                     indices,
+                     GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    } else {
+        stream.init(sizeof(Quad::Vertex) * Quad::LENGTH, MAX_QUADS);
+    }
+
+    // Every page costs ATLASW * ATLASH * 4 bytes of video memory.
+    GLint max_pages = MAX_PAGES;
+    if (core_profile) {
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_pages);
+    }
+    page_count = static_cast<GLushort>(
+        std::clamp<GLint>(Configuration::get().video.atlas_pages,
+                          1,
+                          std::min<GLint>(max_pages, MAX_PAGES)));
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (core_profile) {
+        atlas.resize(1);
+        glGenTextures(1, atlas.data());
+        glBindTexture(GL_TEXTURE_2D_ARRAY, atlas[0]);
+        glTexParameteri(
+            GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(
+            GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                     0,
+                     GL_RGBA8,
+                     ATLASW,
+                     ATLASH,
+                     page_count,
+                     0,
+                     GL_RGBA,
+                     GL_UNSIGNED_BYTE,
+                     nullptr);
+    } else {
+        atlas.resize(page_count);
+        glGenTextures(page_count, atlas.data());
+        for (GLuint texture : atlas) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D,
+                         0,
+                         GL_RGBA,
+                         ATLASW,
+                         ATLASH,
+                         0,
+                         GL_RGBA,
+                         GL_UNSIGNED_BYTE,
+                         nullptr);
+        }
+    }
+
+    if (GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range) {
+        glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER,
+                     PIXEL_BUFFER_SIZE,
+                     nullptr,
+                     GL_STREAM_DRAW);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    if (core_profile && gl.composite_capacity > 0) {
+        init_composites();
+    }
+
+    return Error::NONE;
+}
+
+void GraphicsGL::GLBackend::init_composites()
+{
+    // Covers the viewport with two triangles, and copies the texel of the
+    // scratch texture under every pixel.
+    static constexpr const char* const vs_source
+        = "#version 330 core\n"
+
+          "void main(void) {"
+          "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);"
+          "    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);"
+          "}";
+    static constexpr const char* const fs_source
+        = "#version 330 core\n"
+          "out vec4 fragcolor;"
+          "uniform sampler2D scratch;"
+          "uniform ivec2 shift;"
+
+          "void main(void) {"
+          "    ivec2 pos = ivec2(gl_FragCoord.xy) - shift;"
+          "    vec4 c = texelFetch(scratch, pos, 0);"
+          "    fragcolor = c.a > 0.0 ? vec4(c.rgb / c.a, c.a) : vec4(0.0);"
+          "}";
+
+    GLint result = GL_FALSE;
+
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &vs_source, NULL);
+    glCompileShader(vs);
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &result);
+    if (!result) {
+        return;
+    }
+
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs, 1, &fs_source, NULL);
+    glCompileShader(fs);
+    glGetShaderiv(fs, GL_COMPILE_STATUS, &result);
+    if (!result) {
+        return;
+    }
+
+    GLuint resolve = glCreateProgram();
+    glAttachShader(resolve, vs);
+    glAttachShader(resolve, fs);
+    glLinkProgram(resolve);
+    glGetProgramiv(resolve, GL_LINK_STATUS, &result);
+    if (!result) {
+        return;
+    }
+
+    uniform_scratch = glGetUniformLocation(resolve, "scratch");
+    uniform_shift = glGetUniformLocation(resolve, "shift");
+    if (uniform_scratch == -1 || uniform_shift == -1) {
+        return;
+    }
+
+    resolve_program = resolve;
+    glUseProgram(resolve_program);
+    glUniform1i(uniform_scratch, 1);
+    glUseProgram(0);
+
+    glGenTextures(1, &scratch_texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scratch_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D,
+                 0,
+                 GL_RGBA8,
+                 SCRATCH_SIZE,
+                 SCRATCH_SIZE,
+                 0,
+                 GL_RGBA,
+                 GL_UNSIGNED_BYTE,
+                 nullptr);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+bool GraphicsGL::GLBackend::init_composite_targets()
+{
+    if (!resolve_program) {
+        return false;
+    }
+
+    // Like vertex array objects, framebuffers are not shared between
+    // contexts.
+    if (scratch_fbo) {
+        glDeleteFramebuffers(1, &scratch_fbo);
+        glDeleteFramebuffers(1, &atlas_fbo);
+        glDeleteVertexArrays(1, &resolve_vao);
+    }
+    glGenFramebuffers(1, &scratch_fbo);
+    glGenFramebuffers(1, &atlas_fbo);
+    glGenVertexArrays(1, &resolve_vao);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, scratch_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER,
+                           GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D,
+                           scratch_texture,
+                           0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER)
+                    == GL_FRAMEBUFFER_COMPLETE;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, atlas_fbo);
+    glFramebufferTextureLayer(
+        GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, atlas[0], 0, 0);
+    complete = complete
+               && glCheckFramebufferStatus(GL_FRAMEBUFFER)
+                      == GL_FRAMEBUFFER_COMPLETE;
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return complete;
+}
+
+void GraphicsGL::GLBackend::reinit(GraphicsGL& gl)
+{
+    glUseProgram(program);
+
+    glUniform1i(uniform_y_offset, Constants::VIEW_Y_OFFSET);
+    glUniform1i(uniform_font_region, gl.font_y_max);
+    glUniform2f(uniform_atlas_size, ATLASW, ATLASH);
+    glUniform2f(uniform_screen_size,
+                Window::get().get_width(),
+                Window::get().get_height());
+
+    if (core_profile) {
+        // Vertex array objects are not shared between contexts, so a new one
+        // is needed whenever the window is recreated.
+        if (vao) {
+            glDeleteVertexArrays(1, &vao);
+        }
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+        for (GLint attribute : {attribute_rect,
+                                attribute_texrect,
+                                attribute_color,
+                                attribute_angle,
+                                attribute_page,
+                                attribute_period}) {
+            glEnableVertexAttribArray(attribute);
+            glVertexAttribDivisor(attribute, 1);
+        }
+
+        set_instance_pointers(stream.id(), 0);
+        glBindVertexArray(0);
+
+        gl.composites_enabled = init_composite_targets();
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, stream.id());
+        glVertexAttribPointer(attribute_position,
+                              2,
+                              GL_SHORT,
+                              GL_FALSE,
+                              sizeof(Quad::Vertex),
+                              (const void*)offsetof(Quad::Vertex, x));
+        glVertexAttribPointer(attribute_texcoord,
+                              2,
+                              GL_UNSIGNED_SHORT,
+                              GL_FALSE,
+                              sizeof(Quad::Vertex),
+                              (const void*)offsetof(Quad::Vertex, s));
+        glVertexAttribPointer(attribute_color,
+                              4,
+                              GL_UNSIGNED_BYTE,
+                              GL_TRUE,
+                              sizeof(Quad::Vertex),
+                              (const void*)offsetof(Quad::Vertex, c));
+    }
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    if (core_profile) {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, atlas[0]);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+}
+
+void GraphicsGL::GLBackend::set_instance_pointers(GLuint buffer,
+                                                  GLint first)
+{
+    const std::size_t base = sizeof(Quad) * static_cast<std::size_t>(first);
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(attribute_rect,
+                          4,
+                          GL_SHORT,
+                          GL_FALSE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, x0)));
+    glVertexAttribPointer(attribute_texrect,
+                          4,
+                          GL_UNSIGNED_SHORT,
+                          GL_FALSE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, s0)));
+    glVertexAttribPointer(attribute_color,
+                          4,
+                          GL_UNSIGNED_BYTE,
+                          GL_TRUE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, color)));
+    glVertexAttribPointer(attribute_angle,
+                          1,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, angle)));
+    glVertexAttribPointer(attribute_page,
+                          1,
+                          GL_UNSIGNED_SHORT,
+                          GL_FALSE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, page)));
+    glVertexAttribPointer(attribute_period,
+                          2,
+                          GL_SHORT,
+                          GL_FALSE,
+                          sizeof(Quad),
+                          (const void*)(base + offsetof(Quad, period_x)));
+}
+
+void GraphicsGL::GLBackend::upload(GLushort page,
+                                   GLshort x,
+                                   GLshort y,
+                                   GLshort w,
+                                   GLshort h,
+                                   GLenum format,
+                                   const void* pixels)
+{
+    if (core_profile) {
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                        0,
+                        x,
+                        y,
+                        page,
+                        w,
+                        h,
+                        1,
+                        format,
+                        GL_UNSIGNED_BYTE,
+                        pixels);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, atlas[page]);
+        glTexSubImage2D(
+            GL_TEXTURE_2D, 0, x, y, w, h, format, GL_UNSIGNED_BYTE, pixels);
+    }
+}
+
+void GraphicsGL::GLBackend::begin_uploads()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+}
+
+void GraphicsGL::GLBackend::upload_bitmap(const Offset& o,
+                                          const std::uint8_t* pixels,
+                                          std::size_t size)
+{
+    GLshort w = o.r - o.l;
+    GLshort h = o.b - o.t;
+    if (std::size_t offset; stage_pixels(pixels, size, offset)) {
+        upload(o.page,
+               o.l,
+               o.t,
+               w,
+               h,
+               GL_BGRA,
+               reinterpret_cast<const void*>(offset));
+    } else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        upload(o.page, o.l, o.t, w, h, GL_BGRA, pixels);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    }
+}
+
+void GraphicsGL::GLBackend::end_uploads()
+{
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+bool GraphicsGL::GLBackend::stage_pixels(const std::uint8_t* pixels,
+                                         std::size_t size,
+                                         std::size_t& offset)
+{
+    if (!pbo || size > PIXEL_BUFFER_SIZE) {
+        return false;
+    }
+
+    // Orphan the buffer once it is full, so that the driver can hand out
+    // fresh storage while earlier uploads are still in flight.
+    if (pbo_offset + size > PIXEL_BUFFER_SIZE) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER,
+                     PIXEL_BUFFER_SIZE,
+                     nullptr,
+                     GL_STREAM_DRAW);
+        pbo_offset = 0;
+    }
+
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT
+                             | GL_MAP_UNSYNCHRONIZED_BIT;
+    void* dest = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER,
+                                  static_cast<GLintptr>(pbo_offset),
+                                  static_cast<GLsizeiptr>(size),
+                                  flags);
+    if (!dest) {
+        return false;
+    }
+
+    std::memcpy(dest, pixels, size);
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        return false;
+    }
+
+    offset = pbo_offset;
+    pbo_offset += size;
+    return true;
+}
+
+GLuint GraphicsGL::GLBackend::create_static(const Quad* quads,
+                                            std::size_t count)
+{
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(count * sizeof(Quad)),
+                 quads,
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return buffer;
+}
+
+void GraphicsGL::GLBackend::delete_static(const std::vector<GLuint>& buffers)
+{
+    glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+}
+
+void GraphicsGL::GLBackend::render_composites(
+    const std::vector<CompositeJob>& jobs,
+    GLint first)
+{
+    if (jobs.empty()) {
+        return;
+    }
+
+    // Where each composite is rendered in the scratch texture.
+    std::vector<Point<std::int16_t>> scratch(jobs.size());
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, scratch_texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    std::size_t begin = 0;
+    while (begin < jobs.size()) {
+        // Draw as many composites as fit into the scratch texture, in rows.
+        // The quads are moved so that their top left corner is at the
+        // position in the scratch texture, and the y axis is flipped so
+        // that rows end up in the same order as in the atlas.
+        glBindFramebuffer(GL_FRAMEBUFFER, scratch_fbo);
+        glViewport(0, 0, SCRATCH_SIZE, SCRATCH_SIZE);
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        glUseProgram(program);
+        glBindVertexArray(vao);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glUniform2f(uniform_screen_size, SCRATCH_SIZE, -SCRATCH_SIZE);
+        glUniform1i(uniform_y_offset, -SCRATCH_SIZE);
+        glUniform1f(uniform_opacity, 1.0f);
+        glUniform1i(uniform_composite, 1);
+
+        GLshort x = 0;
+        GLshort y = 0;
+        GLshort row = 0;
+        std::size_t end = begin;
+        for (; end < jobs.size(); ++end) {
+            const CompositeJob& job = jobs[end];
+            const Offset& o = job.offset;
+            GLshort w = o.r - o.l;
+            GLshort h = o.b - o.t;
+            if (x + w > SCRATCH_SIZE) {
+                x = 0;
+                y += row;
+                row = 0;
+            }
+            if (y + h > SCRATCH_SIZE) {
+                break;
+            }
+
+            scratch[end] = {x, y};
+            x += w;
+            row = std::max(row, h);
+
+            set_instance_pointers(stream.id(), first + job.first);
+            glUniform2f(uniform_offset,
+                        scratch[end].x() - job.origin.x(),
+                        scratch[end].y() - job.origin.y());
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                    INDICES_PER_QUAD,
+                                    GL_UNSIGNED_INT,
+                                    nullptr,
+                                    job.count);
+        }
+
+        // Copy every composite into its region of the atlas.
+        glBindFramebuffer(GL_FRAMEBUFFER, atlas_fbo);
+        glUseProgram(resolve_program);
+        glBindVertexArray(resolve_vao);
+        glDisable(GL_BLEND);
+
+        GLint attached = -1;
+        for (std::size_t i = begin; i < end; ++i) {
+            const Offset& o = jobs[i].offset;
+            if (o.page != attached) {
+                glFramebufferTextureLayer(GL_FRAMEBUFFER,
+                                          GL_COLOR_ATTACHMENT0,
+                                          atlas[0],
+                                          0,
+                                          o.page);
+                attached = o.page;
+            }
+
+            glViewport(o.l, o.t, o.r - o.l, o.b - o.t);
+            glUniform2i(uniform_shift,
+                        o.l - scratch[i].x(),
+                        o.t - scratch[i].y());
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+
+        begin = end;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, Window::get().get_width(), Window::get().get_height());
+    glUseProgram(program);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glUniform2f(uniform_screen_size,
+                Window::get().get_width(),
+                Window::get().get_height());
+    glUniform1i(uniform_y_offset, Constants::VIEW_Y_OFFSET);
+    glUniform1i(uniform_composite, 0);
+}
+
+void GraphicsGL::GLBackend::flush(const Frame& frame)
+{
+    GLint first = stream.commit();
+    if (core_profile) {
+        render_composites(frame.composite_jobs, first);
+    }
+
+    // Fading is done by darkening every fragment in the shader rather than by
+    // drawing a cover quad, so that a locked scene can be redrawn without
+    // writing to a region the GPU may still be reading from.
+    glUniform1f(uniform_opacity, frame.opacity);
+    glClearColor(frame.opacity, frame.opacity, frame.opacity, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (core_profile) {
+        // Without GL 4.2 there is no base instance, so the instance
+        // attributes are pointed at the current region instead.
+        glBindVertexArray(vao);
+        for (const Command& command : frame.commands) {
+            if (command.buffer) {
+                set_instance_pointers(command.buffer, command.first);
+            } else {
+                set_instance_pointers(stream.id(), first + command.first);
+            }
+
+            glUniform2f(uniform_offset,
+                        command.offset.x(),
+                        command.offset.y());
+            glDrawElementsInstanced(GL_TRIANGLES,
+                                    INDICES_PER_QUAD,
+                                    GL_UNSIGNED_INT,
+                                    nullptr,
+                                    command.count);
+        }
+        stream.fence();
+        glBindVertexArray(0);
+    } else {
+        glEnableVertexAttribArray(attribute_position);
+        glEnableVertexAttribArray(attribute_texcoord);
+        glEnableVertexAttribArray(attribute_color);
+        glBindBuffer(GL_ARRAY_BUFFER, stream.id());
+        for (const Batch& batch : frame.batches) {
+            glBindTexture(GL_TEXTURE_2D, atlas[batch.page]);
+            glUniform1i(uniform_page, batch.page);
+            glDrawArrays(GL_QUADS,
+                         (first + batch.first)
+                             * static_cast<GLint>(Quad::LENGTH),
+                         batch.count * static_cast<GLsizei>(Quad::LENGTH));
+        }
+        stream.fence();
+
+        glDisableVertexAttribArray(attribute_position);
+        glDisableVertexAttribArray(attribute_texcoord);
+        glDisableVertexAttribArray(attribute_color);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+} // namespace jrc
@@ -0,0 +1,111 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "GraphicsGL.h"
+
+namespace jrc
+{
+//! The backend which draws with OpenGL.
+class GraphicsGL::GLBackend : public GraphicsGL::Backend
+{
+public:
+    explicit GLBackend(StreamBuffer& s) noexcept;
+
+    Error init(GraphicsGL& gl, GLushort& page_count) override;
+    void reinit(GraphicsGL& gl) override;
+
+    void upload(GLushort page,
+                GLshort x,
+                GLshort y,
+                GLshort w,
+                GLshort h,
+                GLenum format,
+                const void* pixels) override;
+    void begin_uploads() override;
+    void upload_bitmap(const Offset& offset,
+                       const std::uint8_t* pixels,
+                       std::size_t size) override;
+    void end_uploads() override;
+
+    GLuint create_static(const Quad* quads, std::size_t count) override;
+    void delete_static(const std::vector<GLuint>& buffers) override;
+
+    void flush(const Frame& frame) override;
+
+private:
+    void set_instance_pointers(GLuint buffer, GLint first);
+    //! Copy pixels into the pixel buffer. Returns `false` if they have to be
+    //! uploaded from client memory instead.
+    bool stage_pixels(const std::uint8_t* pixels,
+                      std::size_t size,
+                      std::size_t& offset);
+
+    //! Render the pending composites into the atlas. They are drawn into
+    //! a scratch texture first, and then copied into the atlas with their
+    //! colors divided by alpha again.
+    void render_composites(const std::vector<CompositeJob>& jobs,
+                           GLint first);
+    //! Create the shader program and texture for rendering composites.
+    void init_composites();
+    //! Create the framebuffers which the composites are rendered with.
+    //! Returns `false` if they are not complete.
+    bool init_composite_targets();
+
+    static const GLsizei INDICES_PER_QUAD = 6;
+    static const std::size_t PIXEL_BUFFER_SIZE = 0x1000000;
+
+    StreamBuffer& stream;
+    bool core_profile;
+
+    GLuint ibo;
+    GLuint vao;
+    GLuint pbo;
+    std::size_t pbo_offset;
+    //! The atlas is one texture array on the core profile path, and one
+    //! texture per page otherwise.
+    std::vector<GLuint> atlas;
+
+    GLint program;
+    GLint attribute_position;
+    GLint attribute_texcoord;
+    GLint attribute_rect;
+    GLint attribute_texrect;
+    GLint attribute_angle;
+    GLint attribute_page;
+    GLint attribute_color;
+    GLint attribute_period;
+    GLint uniform_texture;
+    GLint uniform_atlas_size;
+    GLint uniform_screen_size;
+    GLint uniform_y_offset;
+    GLint uniform_font_region;
+    GLint uniform_opacity;
+    GLint uniform_page;
+    GLint uniform_offset;
+    GLint uniform_composite;
+
+    //! Objects for rendering composites.
+    GLuint resolve_program;
+    GLint uniform_scratch;
+    GLint uniform_shift;
+    GLuint resolve_vao;
+    GLuint scratch_texture;
+    GLuint scratch_fbo;
+    GLuint atlas_fbo;
+};
+} // namespace jrc
@@ -0,0 +1,209 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "GlyphCache.h"
+
+#include "../Util/Profiler.h"
+
+#include <algorithm>
+
+namespace jrc
+{
+GraphicsGL::GlyphCache::GlyphCache(GraphicsGL& g) noexcept
+    : gl{g}, cells(COLUMNS * ROWS, Cell{EMPTY, 0}), epoch{0}
+{
+    free_cells.reserve(cells.size());
+    for (auto i = static_cast<std::uint32_t>(cells.size()); i-- > 0;) {
+        free_cells.push_back(i);
+    }
+}
+
+GraphicsGL::GlyphCache::~GlyphCache()
+{
+    for (Face& face : faces) {
+        if (face.face) {
+            FT_Done_Face(face.face);
+        }
+    }
+}
+
+bool GraphicsGL::GlyphCache::add_font(FT_Library library,
+                                      const char* path,
+                                      Text::Font font,
+                                      FT_UInt height)
+{
+    FT_Face face;
+    if (FT_New_Face(library, path, 0, &face)) {
+        return false;
+    }
+
+    if (FT_Set_Pixel_Sizes(face, 0, height)) {
+        FT_Done_Face(face);
+        return false;
+    }
+
+    faces[font].face = face;
+    for (char32_t c = 32; c < 127; ++c) {
+        const Glyph& glyph = find(font, c);
+        faces[font].height = std::max(faces[font].height, glyph.bh);
+    }
+
+    return true;
+}
+
+const GraphicsGL::GlyphCache::Glyph&
+GraphicsGL::GlyphCache::find(Text::Font font, char32_t codepoint)
+{
+    auto [iter, inserted] = glyphs.try_emplace(key(font, codepoint));
+    if (inserted) {
+        ++stats.misses;
+        rasterise(iter->second, font, codepoint);
+    }
+
+    return iter->second;
+}
+
+const GraphicsGL::GlyphCache::Glyph&
+GraphicsGL::GlyphCache::use(Text::Font font, char32_t codepoint)
+{
+    auto [iter, inserted] = glyphs.try_emplace(key(font, codepoint));
+    Glyph& glyph = iter->second;
+    if (inserted || (glyph.cell == NO_CELL && !glyph.blank)) {
+        ++stats.misses;
+        rasterise(glyph, font, codepoint);
+    } else {
+        ++stats.hits;
+    }
+
+    if (glyph.cell != NO_CELL) {
+        glyph.offset.last_used = gl.frame;
+        cells[glyph.cell].last_used = gl.frame;
+    }
+
+    return glyph;
+}
+
+void GraphicsGL::GlyphCache::touch(std::uint32_t cell) noexcept
+{
+    ++stats.hits;
+    cells[cell].last_used = gl.frame;
+}
+
+std::uint64_t GraphicsGL::GlyphCache::get_epoch() const noexcept
+{
+    return epoch;
+}
+
+std::int16_t GraphicsGL::GlyphCache::line_space(Text::Font font) const
+    noexcept
+{
+    return static_cast<std::int16_t>(faces[font].height * 1.35 + 1);
+}
+
+void GraphicsGL::GlyphCache::begin_frame() noexcept
+{
+    stats.frame_time = std::chrono::microseconds::zero();
+}
+
+const GraphicsGL::GlyphStats& GraphicsGL::GlyphCache::get_stats() const
+    noexcept
+{
+    return stats;
+}
+
+std::uint64_t GraphicsGL::GlyphCache::key(Text::Font font,
+                                          char32_t codepoint) noexcept
+{
+    return std::uint64_t{font} << 32 | codepoint;
+}
+
+void GraphicsGL::GlyphCache::rasterise(Glyph& glyph,
+                                       Text::Font font,
+                                       char32_t codepoint)
+{
+    FT_Face face = faces[font].face;
+    if (!face) {
+        return;
+    }
+
+    Profiler::Scope scope{"GlyphCache::rasterise"};
+    auto start = std::chrono::steady_clock::now();
+
+    if (FT_Load_Char(face, codepoint, FT_LOAD_RENDER)) {
+        return;
+    }
+
+    FT_GlyphSlot g = face->glyph;
+    glyph.ax = static_cast<GLshort>(g->advance.x >> 6);
+    glyph.bl = static_cast<GLshort>(g->bitmap_left);
+    glyph.bt = static_cast<GLshort>(g->bitmap_top);
+    glyph.bw = static_cast<GLshort>(g->bitmap.width);
+    glyph.bh = static_cast<GLshort>(g->bitmap.rows);
+
+    // Glyphs which are too large for a cell are left out rather than
+    // clipped. None of the font sizes in use come close.
+    glyph.blank = glyph.bw <= 0 || glyph.bh <= 0 || glyph.bw > CELL_SIZE
+                  || glyph.bh > CELL_SIZE;
+    if (!glyph.blank) {
+        std::uint32_t cell = take_cell();
+        if (cell != NO_CELL) {
+            auto x = static_cast<GLshort>(cell % COLUMNS * CELL_SIZE);
+            auto y = static_cast<GLshort>(1 + cell / COLUMNS * CELL_SIZE);
+            gl.upload(0, x, y, glyph.bw, glyph.bh, GL_RED, g->bitmap.buffer);
+
+            glyph.offset = Offset(x, y, glyph.bw, glyph.bh, 0);
+            glyph.cell = cell;
+            cells[cell] = {key(font, codepoint), gl.frame};
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    stats.frame_time += elapsed;
+    stats.worst_frame_time
+        = std::max(stats.worst_frame_time, stats.frame_time);
+    stats.entries = glyphs.size();
+}
+
+std::uint32_t GraphicsGL::GlyphCache::take_cell()
+{
+    if (!free_cells.empty()) {
+        std::uint32_t cell = free_cells.back();
+        free_cells.pop_back();
+        return cell;
+    }
+
+    // Glyphs drawn in the current frame may already be referred to by quads
+    // in the stream.
+    std::uint32_t victim = NO_CELL;
+    for (std::uint32_t i = 0; i < cells.size(); ++i) {
+        if (cells[i].last_used < gl.frame
+            && (victim == NO_CELL
+                || cells[i].last_used < cells[victim].last_used)) {
+            victim = i;
+        }
+    }
+
+    if (victim != NO_CELL) {
+        glyphs.find(cells[victim].key)->second.cell = NO_CELL;
+        ++stats.evictions;
+        ++epoch;
+    }
+
+    return victim;
+}
+} // namespace jrc
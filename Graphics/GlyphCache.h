@@ -0,0 +1,122 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "GraphicsGL.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace jrc
+{
+//! The glyphs of the fonts, rasterised with FreeType when they are first
+//! needed.
+//!
+//! Glyph bitmaps are kept in a grid of equally sized cells at the top of the
+//! first atlas page, which the shaders read as coverage instead of colour.
+//! When the grid is full, the least recently used glyph which has not been
+//! drawn in the current frame makes room. Its metrics are kept, so that
+//! laying out text with it again does not need FreeType.
+class GraphicsGL::GlyphCache
+{
+public:
+    static const GLshort CELL_SIZE = 32;
+    static const GLshort COLUMNS = ATLASW / CELL_SIZE;
+    static const GLshort ROWS = 8;
+    //! The height of the glyph region, including the unused first row.
+    static const GLshort REGION_HEIGHT = 1 + ROWS * CELL_SIZE;
+    static const std::uint32_t NO_CELL = ~std::uint32_t{0};
+
+    struct Glyph {
+        GLshort ax = 0;
+        GLshort bw = 0;
+        GLshort bh = 0;
+        GLshort bl = 0;
+        GLshort bt = 0;
+        Offset offset;
+        //! The cell holding the bitmap, or `NO_CELL` if it is not in the
+        //! atlas.
+        std::uint32_t cell = NO_CELL;
+        //! Whether there is nothing to draw, e.g. for spaces.
+        bool blank = true;
+    };
+
+    explicit GlyphCache(GraphicsGL& gl) noexcept;
+    ~GlyphCache();
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    //! Load a font, and rasterise the printable ASCII characters.
+    bool add_font(FT_Library library,
+                  const char* path,
+                  Text::Font font,
+                  FT_UInt height);
+
+    //! Return the metrics of a glyph, rasterising it if it was never used.
+    const Glyph& find(Text::Font font, char32_t codepoint);
+    //! Return a glyph for drawing in the current frame, rasterising it if it
+    //! is not in the atlas.
+    const Glyph& use(Text::Font font, char32_t codepoint);
+
+    //! Mark a cell as drawn in the current frame, for quads which were
+    //! built from its glyph earlier.
+    void touch(std::uint32_t cell) noexcept;
+    //! Return a number which changes whenever a glyph leaves the atlas, so
+    //! that quads built before may be stale.
+    std::uint64_t get_epoch() const noexcept;
+
+    std::int16_t line_space(Text::Font font) const noexcept;
+
+    //! Start counting the time spent rasterising anew.
+    void begin_frame() noexcept;
+    const GlyphStats& get_stats() const noexcept;
+
+private:
+    struct Face {
+        FT_Face face = nullptr;
+        //! The height of the tallest printable ASCII character.
+        GLshort height = 0;
+    };
+
+    struct Cell {
+        //! The key of the glyph in the cell, or `EMPTY`.
+        std::uint64_t key;
+        std::uint64_t last_used;
+    };
+
+    static const std::uint64_t EMPTY = ~std::uint64_t{0};
+
+    static std::uint64_t key(Text::Font font, char32_t codepoint) noexcept;
+
+    //! Load the metrics and bitmap of a glyph with FreeType, and copy the
+    //! bitmap into a cell.
+    void rasterise(Glyph& glyph, Text::Font font, char32_t codepoint);
+    //! Take a free cell, or the least recently used one. Returns `NO_CELL`
+    //! if every cell has been drawn in the current frame.
+    std::uint32_t take_cell();
+
+    GraphicsGL& gl;
+    Face faces[Text::NUM_FONTS];
+    std::unordered_map<std::uint64_t, Glyph> glyphs;
+    std::vector<Cell> cells;
+    std::vector<std::uint32_t> free_cells;
+    std::uint64_t epoch;
+    GlyphStats stats;
+};
+} // namespace jrc
@@ -20,8 +20,18 @@
 #include "../Configuration.h"
 #include "../Console.h"
 #include "../IO/Window.h"
+#include "../Util/Profiler.h"
+#include "../Util/Str.h"
+#include "GLBackend.h"
+#include "GlyphCache.h"
+#include "RecordingBackend.h"
+#include "ThreadedBackend.h"
 
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 
 namespace jrc
 {
@@ -34,112 +44,53 @@ GraphicsGL::GraphicsGL()
               -Constants::VIEW_Y_OFFSET,
               -Constants::VIEW_Y_OFFSET + Constants::VIEW_HEIGHT};
     locked = false;
+    core_profile = false;
+    run_start = 0;
+    static_epoch = 0;
+    composites_enabled = false;
+    composite_capacity = 0;
+    capturing = false;
+    capture_complete = true;
+    capture_start = 0;
+    capture_sources = 0;
+    capture_l = 0;
+    capture_r = 0;
+    capture_t = 0;
+    capture_b = 0;
+    recording = nullptr;
+    lru_head = NO_SLOT;
+    lru_tail = NO_SLOT;
+    current_page = 0;
+    atlas_full = false;
+    frame = 0;
+    glyphs = std::make_unique<GlyphCache>(*this);
+    font_y_max = GlyphCache::REGION_HEIGHT;
 }
 
-Error GraphicsGL::init()
+GraphicsGL::~GraphicsGL() = default;
+
+Error GraphicsGL::init(bool headless)
 {
-    if (glewInit()) {
-        return Error::GLEW;
+    const Configuration::Video& video = Configuration::get().video;
+    if (headless) {
+        backend = std::make_unique<RecordingBackend>(stream);
+    } else if (video.render_thread) {
+        backend = std::make_unique<ThreadedBackend>(stream);
+    } else {
+        backend = std::make_unique<GLBackend>(stream);
+    }
+
+    composite_capacity = video.composite_cache;
+
+    GLushort page_count = 1;
+    if (Error error = backend->init(*this, page_count); error) {
+        return error;
     }
 
     if (FT_Init_FreeType(&ft_library)) {
         return Error::FREETYPE;
     }
 
-    GLint result = GL_FALSE;
-
-    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
-    const char* vs_source
-        = "#version 120\n"
-          "attribute vec4 coord;"
-          "attribute vec4 color;"
-          "varying vec2 texpos;"
-          "varying vec4 colormod;"
-          "uniform vec2 screensize;"
-          "uniform int yoffset;"
-
-          "void main(void) {"
-          "    float x = -1.0 + coord.x * 2.0 / screensize.x;"
-          "    float y = 1.0 - (coord.y + yoffset) * 2.0 / screensize.y;"
-          "    gl_Position = vec4(x, y, 0.0, 1.0);"
-          "    texpos = coord.zw;"
-          "    colormod = color;"
-          "}";
-    glShaderSource(vs, 1, &vs_source, NULL);
-    glCompileShader(vs);
-    glGetShaderiv(vs, GL_COMPILE_STATUS, &result);
-    if (!result) {
-        return Error::VERTEX_SHADER;
-    }
-
-    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fs_source
-        = "#version 120\n"
-          "varying vec2 texpos;"
-          "varying vec4 colormod;"
-          "uniform sampler2D texture;"
-          "uniform vec2 atlassize;"
-          "uniform int fontregion;"
-
-          "void main(void) {"
-          "    if (texpos.y == 0) {"
-          "        gl_FragColor = colormod;"
-          "    } else if (texpos.y <= fontregion) {"
-          "        gl_FragColor = vec4(1, 1, 1, texture2D(texture, texpos / "
-          "atlassize).r) * colormod;"
-          "    } else {"
-          "        gl_FragColor = texture2D(texture, texpos / atlassize) * "
-          "colormod;"
-          "    }"
-          "}";
-    glShaderSource(fs, 1, &fs_source, NULL);
-    glCompileShader(fs);
-    glGetShaderiv(fs, GL_COMPILE_STATUS, &result);
-    if (!result) {
-        return Error::FRAGMENT_SHADER;
-    }
-
-    program = glCreateProgram();
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-    glGetProgramiv(program, GL_LINK_STATUS, &result);
-    if (!result) {
-        return Error::SHADER_PROGRAM;
-    }
-
-    attribute_coord = glGetAttribLocation(program, "coord");
-    attribute_color = glGetAttribLocation(program, "color");
-    uniform_texture = glGetUniformLocation(program, "texture");
-    uniform_atlas_size = glGetUniformLocation(program, "atlassize");
-    uniform_screen_size = glGetUniformLocation(program, "screensize");
-    uniform_y_offset = glGetUniformLocation(program, "yoffset");
-    uniform_font_region = glGetUniformLocation(program, "fontregion");
-    if (attribute_coord == -1 || attribute_color == -1 || uniform_texture == -1
-        || uniform_atlas_size == -1 || uniform_y_offset == -1
-        || uniform_screen_size == -1) {
-        return Error::SHADER_VARS;
-    }
-
-    glGenBuffers(1, &vbo);
-
-    glGenTextures(1, &atlas);
-    glBindTexture(GL_TEXTURE_2D, atlas);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexImage2D(GL_TEXTURE_2D,
-                 0,
-                 GL_RGBA,
-                 ATLASW,
-                 ATLASH,
-                 0,
-                 GL_RGBA,
-                 GL_UNSIGNED_BYTE,
-                 nullptr);
-
-    font_border.set_y(1);
-
     const std::string& FONT_NORMAL = Configuration::get().fonts.normal;
     const std::string& FONT_BOLD = Configuration::get().fonts.bold;
     if (FONT_NORMAL.empty() || FONT_BOLD.empty()) {
@@ -150,179 +101,340 @@ Error GraphicsGL::init()
     const char* const FONT_NORMAL_STR = FONT_NORMAL.data();
     const char* const FONT_BOLD_STR = FONT_BOLD.data();
 
-    addfont(FONT_NORMAL_STR, Text::A11L, 0, 11);
-    addfont(FONT_NORMAL_STR, Text::A11M, 0, 11);
-    addfont(FONT_BOLD_STR, Text::A11B, 0, 11);
-    addfont(FONT_NORMAL_STR, Text::A12M, 0, 12);
-    addfont(FONT_BOLD_STR, Text::A12B, 0, 12);
-    addfont(FONT_NORMAL_STR, Text::A13M, 0, 13);
-    addfont(FONT_BOLD_STR, Text::A13B, 0, 13);
-    addfont(FONT_NORMAL_STR, Text::A18M, 0, 18);
-
-    font_y_max += font_border.y();
-
-    leftovers = QuadTree<std::size_t, Leftover>{
-        [](const Leftover& first, const Leftover& second) {
-            bool wcomp = first.width() >= second.width();
-            bool hcomp = first.height() >= second.height();
-            if (wcomp && hcomp) {
-                return QuadTree<std::size_t, Leftover>::RIGHT;
-            } else if (wcomp) {
-                return QuadTree<std::size_t, Leftover>::DOWN;
-            } else if (hcomp) {
-                return QuadTree<std::size_t, Leftover>::UP;
-            } else {
-                return QuadTree<std::size_t, Leftover>::LEFT;
-            }
-        }};
+    glyphs->add_font(ft_library, FONT_NORMAL_STR, Text::A11L, 11);
+    glyphs->add_font(ft_library, FONT_NORMAL_STR, Text::A11M, 11);
+    glyphs->add_font(ft_library, FONT_BOLD_STR, Text::A11B, 11);
+    glyphs->add_font(ft_library, FONT_NORMAL_STR, Text::A12M, 12);
+    glyphs->add_font(ft_library, FONT_BOLD_STR, Text::A12B, 12);
+    glyphs->add_font(ft_library, FONT_NORMAL_STR, Text::A13M, 13);
+    glyphs->add_font(ft_library, FONT_BOLD_STR, Text::A13B, 13);
+    glyphs->add_font(ft_library, FONT_NORMAL_STR, Text::A18M, 18);
+
+    pages.assign(page_count, Page{});
+
+    // A budget of zero means no limit.
+    upload_budget_bytes = video.upload_budget_kb
+                              ? std::size_t{video.upload_budget_kb} * 1024
+                              : SIZE_MAX;
+    // The time budget is kept in clock ticks, so that comparing it with
+    // the elapsed time never converts the maximum, which would overflow.
+    if (video.upload_budget_ms) {
+        upload_budget = std::chrono::milliseconds{video.upload_budget_ms};
+    } else {
+        upload_budget = std::chrono::steady_clock::duration::max();
+    }
+
+    // Decompression has to be serialised anyway, see BitmapLoader, so more
+    // than one worker would only wait on the others.
+    loader.start(1);
 
     return Error::NONE;
 }
 
-bool GraphicsGL::addfont(const char* name,
-                         Text::Font id,
-                         FT_UInt pixelw,
-                         FT_UInt pixelh)
+void GraphicsGL::close()
 {
-    FT_Face face;
-    if (FT_New_Face(ft_library, name, 0, &face)) {
-        return false;
+    loader.stop();
+    if (backend) {
+        backend->stop();
     }
+}
 
-    if (FT_Set_Pixel_Sizes(face, pixelw, pixelh)) {
-        return false;
+void GraphicsGL::reinit()
+{
+    backend->reinit(*this);
+
+    clear_internal();
+}
+
+void GraphicsGL::add_to_batch(const Quad& quad)
+{
+    auto index = static_cast<GLint>(stream.size() - 1);
+
+    // Quads without a texture can join any batch.
+    bool textured = quad.t0 != 0 || quad.t1 != 0;
+    if (batches.empty() || (textured && batches.back().page != quad.page)) {
+        batches.push_back({quad.page, index, 1});
+    } else {
+        ++batches.back().count;
     }
+}
 
-    FT_GlyphSlot g = face->glyph;
+void GraphicsGL::Page::reset(GLshort top)
+{
+    // The first row is never used, as a texture coordinate of zero marks a
+    // quad without a texture.
+    packer.reset(std::max<GLshort>(top, 1));
+    bitmaps.clear();
+    last_used = 0;
+}
 
-    GLshort width = 0;
-    GLshort height = 0;
-    for (std::uint8_t c = 32; c < 128; ++c) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            continue;
+void GraphicsGL::clear_internal()
+{
+    for (std::uint32_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].id) {
+            free_slot(i);
         }
+    }
 
-        GLshort w = static_cast<GLshort>(g->bitmap.width);
-        GLshort h = static_cast<GLshort>(g->bitmap.rows);
+    for (Page& page : pages) {
+        page.reset(0);
+    }
+    pages[0].reset(font_y_max);
+    current_page = 0;
+}
+
+void GraphicsGL::clear()
+{
+    std::size_t used = 0;
+    for (const Page& page : pages) {
+        used += page.packer.allocated_area();
+    }
+
+    double usedpercent
+        = static_cast<double>(used) / (ATLASW * ATLASH * pages.size());
+    if (usedpercent > 0.8) {
+        clear_internal();
+    }
+}
 
-        width += w;
-        if (h > height) {
-            height = h;
+void GraphicsGL::evict(GLushort page_index)
+{
+    Page& page = pages[page_index];
+    for (std::uint32_t index : page.bitmaps) {
+        free_slot(index);
+    }
+
+    atlas_stats.evictions += page.bitmaps.size();
+    ++atlas_stats.page_evictions;
+
+    page.reset(page_index == 0 ? font_y_max : 0);
+}
+
+bool GraphicsGL::evict_region(GLshort w,
+                              GLshort h,
+                              GLushort& page_index,
+                              Point<GLshort>& pos)
+{
+    // Only bitmaps which have not been drawn in the current frame are
+    // candidates, as quads referring to them may already be in the stream.
+    // They are all ahead of those which have in the list.
+    std::uint32_t victim = lru_head;
+    while (victim != NO_SLOT) {
+        const Slot& slot = slots[victim];
+        const Offset& o = slot.offset;
+        if (o.last_used >= frame) {
+            return false;
+        }
+
+        if (!slot.pins && o.r - o.l >= w && o.b - o.t >= h) {
+            break;
         }
+
+        victim = slot.lru_next;
+    }
+
+    if (victim == NO_SLOT) {
+        return false;
     }
 
-    if (font_border.x() + width > ATLASW) {
-        font_border.set_x(0);
-        font_border.set_y(font_y_max);
-        font_y_max = 0;
+    page_index = slots[victim].offset.page;
+    release_slot(victim);
+    ++atlas_stats.evictions;
+
+    return pages[page_index].packer.insert(w, h, pos);
+}
+
+void GraphicsGL::unplace_slot(std::uint32_t index)
+{
+    const Offset& o = slots[index].offset;
+    Page& page = pages[o.page];
+
+    auto& ids = page.bitmaps;
+    auto id_iter = std::find(ids.begin(), ids.end(), index);
+    if (id_iter != ids.end()) {
+        *id_iter = ids.back();
+        ids.pop_back();
     }
 
-    GLshort x = font_border.x();
-    GLshort y = font_border.y();
+    page.packer.release(o.l, o.t, o.r - o.l, o.b - o.t);
+}
 
-    font_border.shift_x(width);
-    if (height > font_y_max) {
-        font_y_max = height;
+void GraphicsGL::release_slot(std::uint32_t index)
+{
+    unplace_slot(index);
+    free_slot(index);
+}
+
+bool GraphicsGL::allocate(GLshort w,
+                          GLshort h,
+                          GLushort& page_index,
+                          Point<GLshort>& pos)
+{
+    // Try every page before evicting anything. A single region is freed if
+    // one is large enough, and a whole page otherwise.
+    page_index = current_page;
+    bool found = false;
+    for (std::size_t i = 0; !found && i < pages.size(); ++i) {
+        page_index = static_cast<GLushort>((current_page + i) % pages.size());
+        found = pages[page_index].packer.insert(w, h, pos);
     }
 
-    fonts[id] = Font(width, height);
+    if (!found) {
+        found = evict_region(w, h, page_index, pos);
+    }
 
-    GLshort ox = x;
-    GLshort oy = y;
-    for (std::uint8_t c = 32; c < 128; ++c) {
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER)) {
-            continue;
+    // Pages used in the current frame are kept, as quads referring to them
+    // may already be in the stream.
+    if (!found) {
+        bool any = false;
+        for (GLushort i = 0; i < pages.size(); ++i) {
+            std::uint64_t last_used = pages[i].last_used;
+            if (last_used < frame
+                && (!any || last_used < pages[page_index].last_used)) {
+                page_index = i;
+                any = true;
+            }
         }
 
-        GLshort ax = static_cast<GLshort>(g->advance.x >> 6);
-        GLshort ay = static_cast<GLshort>(g->advance.y >> 6);
-        GLshort l = static_cast<GLshort>(g->bitmap_left);
-        GLshort t = static_cast<GLshort>(g->bitmap_top);
-        GLshort w = static_cast<GLshort>(g->bitmap.width);
-        GLshort h = static_cast<GLshort>(g->bitmap.rows);
+        if (!any) {
+            atlas_full = true;
+            return false;
+        }
 
-        glTexSubImage2D(GL_TEXTURE_2D,
-                        0,
-                        ox,
-                        oy,
-                        w,
-                        h,
-                        GL_RED,
-                        GL_UNSIGNED_BYTE,
-                        g->bitmap.buffer);
+        evict(page_index);
+        found = pages[page_index].packer.insert(w, h, pos);
+    }
 
-        Offset offset = Offset(ox, oy, w, h);
-        fonts[id].chars[c] = {ax, ay, w, h, l, t, offset};
+    if (found) {
+        current_page = page_index;
+    }
 
-        ox += w;
+    return found;
+}
+
+void GraphicsGL::want(const AtlasHandle& handle)
+{
+    if (handle.slot < slots.size()
+        && slots[handle.slot].generation == handle.generation) {
+        slots[handle.slot].wanted = frame;
     }
+}
 
-    return true;
+void GraphicsGL::upload(GLushort page,
+                        GLshort x,
+                        GLshort y,
+                        GLshort w,
+                        GLshort h,
+                        GLenum format,
+                        const void* pixels)
+{
+    backend->upload(page, x, y, w, h, format, pixels);
 }
 
-void GraphicsGL::reinit()
+void GraphicsGL::add_bitmap(const nl::bitmap& bmp, AtlasHandle& handle)
 {
-    glUseProgram(program);
-
-    glUniform1i(uniform_y_offset, Constants::VIEW_Y_OFFSET);
-    glUniform1i(uniform_font_region, font_y_max);
-    glUniform2f(uniform_atlas_size, ATLASW, ATLASH);
-    glUniform2f(uniform_screen_size,
-                Window::get().get_width(),
-                Window::get().get_height());
-
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexAttribPointer(
-        attribute_coord, 4, GL_SHORT, GL_FALSE, sizeof(Quad::Vertex), 0);
-    glVertexAttribPointer(attribute_color,
-                          4,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          sizeof(Quad::Vertex),
-                          (const void*)8);
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    glBindTexture(GL_TEXTURE_2D, atlas);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    get_offset(bmp, handle);
+}
 
-    clear_internal();
+const GraphicsGL::Offset* GraphicsGL::use_slot(std::uint32_t index)
+{
+    ++atlas_stats.hits;
+
+    touch_slot(index);
+
+    const Slot& slot = slots[index];
+    return slot.resident ? &slot.offset : nullptr;
 }
 
-void GraphicsGL::clear_internal()
+void GraphicsGL::touch_slot(std::uint32_t index)
 {
-    border = Point<GLshort>(0, font_y_max);
-    y_range = Range<GLshort>();
+    Slot& slot = slots[index];
+    pages[slot.offset.page].last_used = frame;
+    if (slot.offset.last_used != frame) {
+        slot.offset.last_used = frame;
+        unlink_slot(index);
+        link_slot(index);
+    }
+}
 
-    offsets.clear();
-    leftovers.clear();
-    rlid = 1;
-    wasted = 0;
+void GraphicsGL::link_slot(std::uint32_t index)
+{
+    Slot& slot = slots[index];
+    slot.lru_prev = lru_tail;
+    slot.lru_next = NO_SLOT;
+    if (lru_tail == NO_SLOT) {
+        lru_head = index;
+    } else {
+        slots[lru_tail].lru_next = index;
+    }
+    lru_tail = index;
 }
 
-void GraphicsGL::clear()
+void GraphicsGL::unlink_slot(std::uint32_t index)
 {
-    std::size_t used = ATLASW * border.y() + border.x() * y_range.second();
-    double usedpercent = static_cast<double>(used) / (ATLASW * ATLASH);
-    if (usedpercent > 80.0) {
-        clear_internal();
+    Slot& slot = slots[index];
+    if (slot.lru_prev == NO_SLOT) {
+        lru_head = slot.lru_next;
+    } else {
+        slots[slot.lru_prev].lru_next = slot.lru_next;
     }
+    if (slot.lru_next == NO_SLOT) {
+        lru_tail = slot.lru_prev;
+    } else {
+        slots[slot.lru_next].lru_prev = slot.lru_prev;
+    }
+    slot.lru_prev = NO_SLOT;
+    slot.lru_next = NO_SLOT;
+}
+
+void GraphicsGL::free_slot(std::uint32_t index)
+{
+    unlink_slot(index);
+
+    Slot& slot = slots[index];
+    if (!slot.composite) {
+        slot_ids.erase(slot.id);
+    }
+    slot.id = 0;
+    slot.composite = false;
+    ++slot.generation;
+
+    if (slot.pins) {
+        ++static_epoch;
+        slot.pins = 0;
+    }
+
+    free_slots.push_back(index);
 }
 
-void GraphicsGL::add_bitmap(const nl::bitmap& bmp)
+std::uint32_t GraphicsGL::new_slot()
 {
-    get_offset(bmp);
+    if (free_slots.empty()) {
+        auto index = static_cast<std::uint32_t>(slots.size());
+        slots.push_back({{}, 0, 1, false, 0, 0, false, NO_SLOT, NO_SLOT});
+        return index;
+    }
+
+    std::uint32_t index = free_slots.back();
+    free_slots.pop_back();
+    return index;
 }
 
-const GraphicsGL::Offset& GraphicsGL::get_offset(const nl::bitmap& bmp)
+const GraphicsGL::Offset* GraphicsGL::get_offset(const nl::bitmap& bmp,
+                                                 AtlasHandle& handle)
 {
+    if (handle.slot < slots.size()) {
+        Slot& slot = slots[handle.slot];
+        if (slot.generation == handle.generation) {
+            return use_slot(handle.slot);
+        }
+    }
+
     std::size_t id = bmp.id();
-    auto offiter = offsets.find(id);
-    if (offiter != offsets.end()) {
-        return offiter->second;
+    auto slot_iter = slot_ids.find(id);
+    if (slot_iter != slot_ids.end()) {
+        handle = {slot_iter->second, slots[slot_iter->second].generation};
+        return use_slot(slot_iter->second);
     }
 
     GLshort x = 0;
@@ -330,128 +442,655 @@ const GraphicsGL::Offset& GraphicsGL::get_offset(const nl::bitmap& bmp)
     GLshort w = bmp.width();
     GLshort h = bmp.height();
 
-    if (w <= 0 || h <= 0) {
-        return null_offset;
+    if (w <= 0 || h <= 0 || w > ATLASW || h > ATLASH - font_y_max) {
+        return &null_offset;
     }
 
-    const auto bmp_data = bmp.data();
-    if (!bmp_data) {
-        return null_offset;
+    ++atlas_stats.misses;
+
+    // With no room left, the bitmap is left out of this frame, and looked
+    // up again in the next.
+    GLushort page_index;
+    Point<GLshort> pos;
+    if (!allocate(w, h, page_index, pos)) {
+        return nullptr;
     }
 
-    auto value = Leftover(x, y, w, h);
-    std::size_t lid = leftovers.find_node(value, [
-    ](const Leftover& val, const Leftover& leaf) noexcept {
-        return val.width() <= leaf.width() && val.height() <= leaf.height();
-    });
+    x = pos.x();
+    y = pos.y();
+
+    std::uint32_t index = new_slot();
+    Slot& slot = slots[index];
+    slot.offset = {x, y, w, h, page_index};
+    slot.offset.last_used = frame;
+    slot.id = id;
+    slot.resident = false;
+    slot.wanted = 0;
+    slot.pins = 0;
+    slot_ids.emplace(id, index);
+    link_slot(index);
+
+    pages[page_index].bitmaps.push_back(index);
+    pages[page_index].last_used = frame;
+
+    handle = {index, slot.generation};
+    loader.push({bmp, index, slot.generation});
+    return nullptr;
+}
 
-    if (lid > 0) {
-        const Leftover& leftover = leftovers[lid];
+void GraphicsGL::upload_bitmaps()
+{
+    Profiler::Scope scope{"GraphicsGL::upload_bitmaps"};
 
-        x = leftover.l;
-        y = leftover.t;
+    auto start = std::chrono::steady_clock::now();
 
-        GLshort wdelta = leftover.width() - w;
-        GLshort hdelta = leftover.height() - h;
+    for (BitmapLoader::Result result; loader.pop(result);) {
+        uploads.push_back(std::move(result));
+    }
 
-        leftovers.erase(lid);
+    // Drop bitmaps whose slot was evicted or reused while they were being
+    // decompressed, and move those which are already on screen to the
+    // front. Both orders are kept, so bitmaps are uploaded in the order in
+    // which they were first needed.
+    auto stale = [&](const BitmapLoader::Result& result) {
+        return result.slot >= slots.size()
+               || slots[result.slot].generation != result.generation;
+    };
+    uploads.erase(std::remove_if(uploads.begin(), uploads.end(), stale),
+                  uploads.end());
+    std::stable_partition(
+        uploads.begin(),
+        uploads.end(),
+        [&](const BitmapLoader::Result& result) {
+            return slots[result.slot].wanted + 1 >= frame;
+        });
+
+    upload_stats.frame_bytes = 0;
+
+    backend->begin_uploads();
+
+    std::size_t uploaded = 0;
+    bool overrun = false;
+    for (BitmapLoader::Result& result : uploads) {
+        // Always upload at least one bitmap, so that the queue drains even
+        // if a single bitmap is over budget.
+        std::size_t size = result.pixels.size();
+        if (uploaded > 0
+            && upload_stats.frame_bytes + size > upload_budget_bytes) {
+            break;
+        }
 
-        wasted -= w * h;
+        Slot& slot = slots[result.slot];
+        Offset& o = slot.offset;
+        slot.resident = true;
+        ++uploaded;
 
-        if (wdelta >= MINLOSIZE && hdelta >= MINLOSIZE) {
-            leftovers.add(rlid, Leftover(x + w, y + h, wdelta, hdelta));
-            ++rlid;
+        if (result.pixels.empty()) {
+            // Bitmaps without data are drawn as a plain rectangle, and so
+            // take up no space on any page.
+            unplace_slot(result.slot);
+            o = Offset();
+            continue;
+        }
 
-            if (w >= MINLOSIZE) {
-                leftovers.add(rlid, Leftover(x, y + h, w, hdelta));
-                ++rlid;
-            }
+        backend->upload_bitmap(o, result.pixels.data(), size);
 
-            if (h >= MINLOSIZE) {
-                leftovers.add(rlid, Leftover(x + w, y, wdelta, h));
-                ++rlid;
-            }
-        } else if (wdelta >= MINLOSIZE) {
-            leftovers.add(rlid, Leftover(x + w, y, wdelta, h + hdelta));
-            ++rlid;
-        } else if (hdelta >= MINLOSIZE) {
-            leftovers.add(rlid, Leftover(x, y + h, w + wdelta, hdelta));
-            ++rlid;
+        upload_stats.frame_bytes += size;
+        upload_stats.total_bytes += size;
+        ++upload_stats.uploads;
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed > upload_budget || size > upload_budget_bytes) {
+            overrun = true;
+            break;
         }
-    } else {
-        if (border.x() + w > ATLASW) {
-            border.set_x(0);
-            border.shift_y(y_range.second());
-            if (border.y() + h > ATLASH) {
-                clear_internal();
-            } else {
-                y_range = Range<GLshort>();
-            }
+    }
+
+    backend->end_uploads();
+
+    uploads.erase(uploads.begin(), uploads.begin() + uploaded);
+
+    if (overrun) {
+        ++upload_stats.overruns;
+    }
+    upload_stats.queue_depth = uploads.size() + loader.pending();
+}
+
+void GraphicsGL::draw(const nl::bitmap& bmp,
+                      AtlasHandle& handle,
+                      const Rectangle<std::int16_t>& rect,
+                      const Color& color,
+                      float angle)
+{
+    if (locked) {
+        return;
+    }
+
+    if (color.invisible()) {
+        return;
+    }
+
+    // Composites and retained groups are kept whole, even if only part of
+    // them is visible.
+    if (!capturing && !recording && !rect.overlaps(screen)) {
+        return;
+    }
+
+    const Offset* offset = get_offset(bmp, handle);
+    if (!offset) {
+        want(handle);
+        capture_complete = false;
+        if (recording) {
+            recording->valid = false;
+        }
+        return;
+    }
+
+    if (recording && offset != &null_offset) {
+        recording->handles.push_back(handle);
+    }
+
+    emplace_quad(rect.l(),
+                 rect.r(),
+                 rect.t(),
+                 rect.b(),
+                 *offset,
+                 color.to_bytes(),
+                 angle);
+
+    if (capturing) {
+        if (offset != &null_offset) {
+            composite_sources.push_back(handle);
+        }
+
+        capture_l = std::min({capture_l, rect.l(), rect.r()});
+        capture_r = std::max({capture_r, rect.l(), rect.r()});
+        capture_t = std::min({capture_t, rect.t(), rect.b()});
+        capture_b = std::max({capture_b, rect.t(), rect.b()});
+        if (angle != 0.0f) {
+            capture_complete = false;
         }
-        x = border.x();
-        y = border.y();
+    }
+}
+
+bool GraphicsGL::draw_composite(const CompositeKey& key,
+                                Point<std::int16_t> pos,
+                                const Color& color)
+{
+    if (!composites_enabled) {
+        return false;
+    }
+
+    if (locked) {
+        return true;
+    }
+
+    auto iter = composites.find(key);
+    if (iter == composites.end()) {
+        ++composite_stats.misses;
+        return false;
+    }
+
+    const Composite& composite = iter->second;
+    Slot& slot = slots[composite.slot];
+    if (slot.generation != composite.generation) {
+        // The atlas needed the space for something else.
+        composites.erase(iter);
+        composite_stats.entries = composites.size();
+        ++composite_stats.misses;
+        return false;
+    }
+
+    ++composite_stats.hits;
+    touch_slot(composite.slot);
 
-        border.shift_x(w);
+    if (recording) {
+        recording->handles.push_back({composite.slot, composite.generation});
+    }
+
+    Rectangle<std::int16_t> rect = composite.bounds;
+    rect.shift(pos);
+    if (!color.invisible() && (recording || rect.overlaps(screen))) {
+        emplace_quad(rect.l(),
+                     rect.r(),
+                     rect.t(),
+                     rect.b(),
+                     slot.offset,
+                     color.to_bytes(),
+                     0.0f);
+    }
 
-        if (h > y_range.second()) {
-            if (x >= MINLOSIZE && h - y_range.second() >= MINLOSIZE) {
-                leftovers.add(
-                    rlid,
-                    Leftover(0, y_range.first(), x, h - y_range.second()));
-                ++rlid;
+    return true;
+}
+
+void GraphicsGL::begin_composite()
+{
+    if (locked || !composites_enabled) {
+        return;
+    }
+
+    // The captured quads are taken out of the stream again, which a
+    // recording would not know about.
+    if (recording) {
+        recording->valid = false;
+    }
+
+    // The captured quads must not join the run before them.
+    close_run();
+
+    capturing = true;
+    capture_complete = true;
+    capture_start = stream.size();
+    capture_sources = composite_sources.size();
+    capture_l = std::numeric_limits<std::int16_t>::max();
+    capture_r = std::numeric_limits<std::int16_t>::min();
+    capture_t = std::numeric_limits<std::int16_t>::max();
+    capture_b = std::numeric_limits<std::int16_t>::min();
+}
+
+void GraphicsGL::end_composite(const CompositeKey& key,
+                               Point<std::int16_t> pos,
+                               const Color& color)
+{
+    if (!capturing) {
+        return;
+    }
+
+    capturing = false;
+
+    // If the composite cannot be cached, the captured quads are simply
+    // drawn like any others.
+    std::size_t end = stream.size();
+    if (!capture_complete || end == capture_start
+        || capture_r - capture_l > SCRATCH_SIZE
+        || capture_b - capture_t > SCRATCH_SIZE) {
+        composite_sources.resize(capture_sources);
+        return;
+    }
+
+    trim_composites();
+
+    // The parts were all drawn in this frame, so making room never evicts
+    // them. Without room, the parts are drawn instead.
+    auto w = static_cast<GLshort>(capture_r - capture_l);
+    auto h = static_cast<GLshort>(capture_b - capture_t);
+    GLushort page_index;
+    Point<GLshort> at;
+    if (!allocate(w, h, page_index, at)) {
+        composite_sources.resize(capture_sources);
+        return;
+    }
+
+    // The slot counts as resident already, as composites are rendered into
+    // the atlas before anything else is drawn.
+    std::uint32_t index = new_slot();
+    Slot& slot = slots[index];
+    slot.offset = {at.x(), at.y(), w, h, page_index};
+    slot.offset.last_used = frame;
+    slot.id = CompositeHash{}(key) | 1;
+    slot.resident = true;
+    slot.wanted = 0;
+    slot.pins = 0;
+    slot.composite = true;
+    link_slot(index);
+
+    pages[page_index].bitmaps.push_back(index);
+    pages[page_index].last_used = frame;
+
+    auto source_count = static_cast<std::uint32_t>(composite_sources.size()
+                                                   - capture_sources);
+    composite_jobs.push_back({index,
+                              slot.generation,
+                              slot.offset,
+                              static_cast<GLint>(capture_start),
+                              static_cast<GLsizei>(end - capture_start),
+                              {capture_l, capture_t},
+                              static_cast<std::uint32_t>(capture_sources),
+                              source_count});
+
+    Rectangle<std::int16_t> bounds{capture_l, capture_r, capture_t, capture_b};
+    bounds.shift(-pos);
+    composites[key] = {index, slot.generation, bounds};
+    composite_stats.entries = composites.size();
+
+    // Leave the captured quads out of the frame, and draw the composite in
+    // their place.
+    run_start = end;
+    if (!color.invisible()) {
+        emplace_quad(capture_l,
+                     capture_r,
+                     capture_t,
+                     capture_b,
+                     slot.offset,
+                     color.to_bytes(),
+                     0.0f);
+    }
+}
+
+void GraphicsGL::trim_composites()
+{
+    if (composites.size() < composite_capacity) {
+        return;
+    }
+
+    // Forget composites which were evicted from the atlas first.
+    for (auto iter = composites.begin(); iter != composites.end();) {
+        const Composite& composite = iter->second;
+        if (slots[composite.slot].generation != composite.generation) {
+            iter = composites.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+
+    // Composites drawn in the current frame are kept even if that goes
+    // over the limit.
+    while (composites.size() >= composite_capacity) {
+        auto victim = composites.end();
+        for (auto iter = composites.begin(); iter != composites.end();
+             ++iter) {
+            std::uint64_t last_used
+                = slots[iter->second.slot].offset.last_used;
+            if (last_used < frame
+                && (victim == composites.end()
+                    || last_used
+                           < slots[victim->second.slot].offset.last_used)) {
+                victim = iter;
             }
+        }
+
+        if (victim == composites.end()) {
+            break;
+        }
+
+        release_slot(victim->second.slot);
+        composites.erase(victim);
+        ++composite_stats.evictions;
+    }
+
+    composite_stats.entries = composites.size();
+}
+
+bool GraphicsGL::draw_retained(RetainedQuads& retained,
+                               Point<std::int16_t> pos)
+{
+    if (locked) {
+        return true;
+    }
+
+    if (!retained.valid || retained.epoch != glyphs->get_epoch()) {
+        return false;
+    }
 
-            wasted += x * (h - y_range.second());
+    for (const AtlasHandle& handle : retained.handles) {
+        if (handle.slot >= slots.size()
+            || slots[handle.slot].generation != handle.generation) {
+            retained.valid = false;
+            return false;
+        }
+    }
+
+    // Keep everything the quads sample from in the atlas, as if it was
+    // drawn again.
+    for (const AtlasHandle& handle : retained.handles) {
+        touch_slot(handle.slot);
+    }
+
+    for (std::uint32_t cell : retained.cells) {
+        glyphs->touch(cell);
+    }
+
+    Point<std::int16_t> shift = pos - retained.origin;
+    auto x = static_cast<GLshort>(shift.x());
+    auto y = static_cast<GLshort>(shift.y());
+    copy_quads(retained.quads.data(),
+               retained.quads.size(),
+               [x, y](Quad& quad, std::size_t) {
+                   quad.x0 += x;
+                   quad.x1 += x;
+                   quad.y0 += y;
+                   quad.y1 += y;
+               });
+
+    retained_stats.replayed += retained.quads.size();
+    return true;
+}
+
+void GraphicsGL::begin_retained(RetainedQuads& retained)
+{
+    if (locked || recording) {
+        return;
+    }
 
-            y_range = {y + h, h};
-        } else if (h < y_range.first() - y) {
-            if (w >= MINLOSIZE && y_range.first() - y - h >= MINLOSIZE) {
-                leftovers.add(rlid,
-                              Leftover(x, y + h, w, y_range.first() - y - h));
-                ++rlid;
+    recording = &retained;
+    retained.quads.clear();
+    retained.handles.clear();
+    retained.cells.clear();
+    retained.valid = true;
+}
+
+void GraphicsGL::end_retained(RetainedQuads& retained,
+                              Point<std::int16_t> pos)
+{
+    if (recording != &retained) {
+        return;
+    }
+
+    recording = nullptr;
+    retained_stats.rebuilt += retained.quads.size();
+
+    // Glyphs rasterised while recording may have evicted others, which the
+    // quads do not use.
+    retained.epoch = glyphs->get_epoch();
+    retained.origin = pos;
+}
+
+void GraphicsGL::record(const Quad& quad)
+{
+    std::memcpy(&recording->quads.emplace_back(), &quad, sizeof(Quad));
+}
+
+void GraphicsGL::draw_tiled(const nl::bitmap& bmp,
+                            AtlasHandle& handle,
+                            const Rectangle<std::int16_t>& rect,
+                            const Color& color,
+                            Point<std::int16_t> period,
+                            Point<std::int16_t> count)
+{
+    if (locked || color.invisible()) {
+        return;
+    }
+
+    // A single quad can only repeat copies which are drawn at their own
+    // size and do not overlap each other.
+    auto w = static_cast<std::int16_t>(std::abs(rect.r() - rect.l()));
+    auto h = static_cast<std::int16_t>(std::abs(rect.b() - rect.t()));
+    bool repeat = core_profile && w == bmp.width() && h == bmp.height()
+                  && w <= period.x() && h <= period.y();
+    if (!repeat) {
+        for (std::int16_t i = 0; i < count.x(); ++i) {
+            for (std::int16_t j = 0; j < count.y(); ++j) {
+                Rectangle<std::int16_t> copy = rect;
+                copy.shift({static_cast<std::int16_t>(i * period.x()),
+                            static_cast<std::int16_t>(j * period.y())});
+                draw(bmp, handle, copy, color, 0.0f);
             }
+        }
+
+        return;
+    }
+
+    auto l = std::min(rect.l(), rect.r());
+    auto t = std::min(rect.t(), rect.b());
+    Rectangle<std::int16_t> area{
+        l,
+        static_cast<std::int16_t>(l + period.x() * (count.x() - 1) + w),
+        t,
+        static_cast<std::int16_t>(t + period.y() * (count.y() - 1) + h)};
+    if (!recording && !area.overlaps(screen)) {
+        return;
+    }
 
-            wasted += w * (y_range.first() - y - h);
+    const Offset* offset = get_offset(bmp, handle);
+    if (!offset) {
+        want(handle);
+        if (recording) {
+            recording->valid = false;
         }
+        return;
     }
 
-    /*
-    std::size_t used = ATLASW * border.y() + border.x() * y_range.second();
-    double usedpercent = static_cast<double>(used) / (ATLASW * ATLASH);
-    double wastedpercent = static_cast<double>(wasted) / used;
-    Console::get().print("Used: " + std::to_string(usedpercent) + ", wasted: "
-    + std::to_string(wastedpercent));
-    */
+    if (recording && offset != &null_offset) {
+        recording->handles.push_back(handle);
+    }
 
-    glTexSubImage2D(
-        GL_TEXTURE_2D, 0, x, y, w, h, GL_BGRA, GL_UNSIGNED_BYTE, bmp_data);
+    Quad quad{area.l(),
+              area.r(),
+              area.t(),
+              area.b(),
+              *offset,
+              color.to_bytes(),
+              0.0f};
+    // Mirrored copies sample the texture from the other edge.
+    if (rect.l() > rect.r()) {
+        std::swap(quad.s0, quad.s1);
+    }
+    if (rect.t() > rect.b()) {
+        std::swap(quad.t0, quad.t1);
+    }
+    quad.period_x = period.x();
+    quad.period_y = period.y();
 
-    return offsets
-        .emplace(std::piecewise_construct,
-                 std::forward_as_tuple(id),
-                 std::forward_as_tuple(x, y, w, h))
-        .first->second;
+    emplace_quad(quad);
 }
 
-void GraphicsGL::draw(const nl::bitmap& bmp,
-                      const Rectangle<std::int16_t>& rect,
-                      const Color& color,
-                      float angle)
+void GraphicsGL::draw_static(const StaticBatch& batch,
+                             Point<std::int16_t> offset)
 {
-    if (locked) {
+    if (locked || batch.entries.empty()) {
         return;
     }
 
-    if (color.invisible()) {
+    // The batch is drawn from a buffer of its own, outside of the stream.
+    if (recording) {
+        recording->valid = false;
+    }
+
+    if (core_profile
+        && ((batch.vbo && batch.epoch == static_epoch)
+            || build_static(batch))) {
+        for (GLushort page : batch.pages) {
+            pages[page].last_used = frame;
+        }
+
+        close_run();
+        commands.push_back({batch.vbo,
+                            0,
+                            static_cast<GLsizei>(batch.entries.size()),
+                            offset});
         return;
     }
 
-    if (!rect.overlaps(screen)) {
+    // Until every bitmap is in the atlas, draw the ones which are.
+    constexpr const Color white{1.0f, 1.0f, 1.0f, 1.0f};
+    for (StaticBatch::Entry& entry : batch.entries) {
+        const Rectangle<std::int16_t>& rect = entry.rect;
+        draw(entry.bitmap,
+             entry.handle,
+             {static_cast<std::int16_t>(rect.l() + offset.x()),
+              static_cast<std::int16_t>(rect.r() + offset.x()),
+              static_cast<std::int16_t>(rect.t() + offset.y()),
+              static_cast<std::int16_t>(rect.b() + offset.y())},
+             white,
+             0.0f);
+    }
+}
+
+bool GraphicsGL::build_static(const StaticBatch& batch)
+{
+    release_static(batch);
+
+    // Every bitmap is looked up even if an earlier one is missing, so that
+    // all of them are queued for loading at once.
+    constexpr const Quad::Rgba white
+        = Color{1.0f, 1.0f, 1.0f, 1.0f}.to_bytes();
+    std::vector<Quad> quads;
+    quads.reserve(batch.entries.size());
+    bool ready = true;
+    for (StaticBatch::Entry& entry : batch.entries) {
+        const Offset* offset = get_offset(entry.bitmap, entry.handle);
+        if (!offset) {
+            ready = false;
+            continue;
+        }
+
+        const Rectangle<std::int16_t>& rect = entry.rect;
+        quads.emplace_back(
+            rect.l(), rect.r(), rect.t(), rect.b(), *offset, white, 0.0f);
+    }
+
+    if (!ready) {
+        return false;
+    }
+
+    // Making room for a later bitmap may have evicted an earlier one.
+    for (const StaticBatch::Entry& entry : batch.entries) {
+        const AtlasHandle& handle = entry.handle;
+        if (handle.slot < slots.size()
+            && slots[handle.slot].generation != handle.generation) {
+            return false;
+        }
+    }
+
+    for (const StaticBatch::Entry& entry : batch.entries) {
+        const AtlasHandle& handle = entry.handle;
+        if (handle.slot >= slots.size()) {
+            continue;
+        }
+
+        Slot& slot = slots[handle.slot];
+        if (!slot.id || slot.generation != handle.generation) {
+            continue;
+        }
+
+        ++slot.pins;
+
+        GLushort page = slot.offset.page;
+        if (std::find(batch.pages.begin(), batch.pages.end(), page)
+            == batch.pages.end()) {
+            batch.pages.push_back(page);
+        }
+    }
+
+    batch.vbo = backend->create_static(quads.data(), quads.size());
+
+    batch.epoch = static_epoch;
+    return true;
+}
+
+void GraphicsGL::release_static(const StaticBatch& batch)
+{
+    if (!batch.vbo) {
         return;
     }
 
-    quads.emplace_back(
-        rect.l(), rect.r(), rect.t(), rect.b(), get_offset(bmp), color, angle);
+    // Bitmaps which were evicted since have already been unpinned.
+    for (const StaticBatch::Entry& entry : batch.entries) {
+        const AtlasHandle& handle = entry.handle;
+        if (handle.slot >= slots.size()) {
+            continue;
+        }
+
+        Slot& slot = slots[handle.slot];
+        if (slot.generation == handle.generation && slot.pins) {
+            --slot.pins;
+        }
+    }
+
+    // The buffer may still be referred to by a command of this frame.
+    static_garbage.push_back(batch.vbo);
+    batch.vbo = 0;
+    batch.pages.clear();
 }
 
 Text::Layout GraphicsGL::create_layout(std::string_view text,
@@ -460,58 +1099,72 @@ Text::Layout GraphicsGL::create_layout(std::string_view text,
                                        std::int16_t max_width,
                                        bool formatted)
 {
-    auto length = text.length();
-    if (length == 0) {
+    if (text.empty()) {
         return {};
     }
 
-    LayoutBuilder builder{fonts[id], alignment, max_width, formatted};
+    return layout_builder.build(
+        *glyphs, text, id, alignment, max_width, formatted);
+}
+
+Text::Layout GraphicsGL::LayoutBuilder::build(GlyphCache& g,
+                                              std::string_view text,
+                                              Text::Font f,
+                                              Text::Alignment a,
+                                              std::int16_t mw,
+                                              bool fm)
+{
+    glyphs = &g;
+    base_font = f;
+    alignment = a;
+    max_width = mw ? mw : Window::get().get_width();
+    formatted = fm;
+
+    font_id = Text::NUM_FONTS;
+    color = Text::NUM_COLORS;
+    ax = 0;
+    ay = glyphs->line_space(base_font);
+    width = 0;
+    endy = 0;
+    run_first = 0;
+    line_first = 0;
+    runs.clear();
+    advances.clear();
 
-    std::string_view::size_type first = 0;
-    std::string_view::size_type offset = 0;
-    while (offset < length) {
+    std::size_t length = text.length();
+    for (std::size_t offset = 0; offset < length;) {
         auto last = text.find_first_of(" \\#", offset + 1, 3);
         if (last == std::string_view::npos) {
             last = length;
         }
 
-        first = builder.add(text, first, offset, last);
+        add(text, offset, last);
         offset = last;
     }
 
-    return builder.finish(first, offset);
+    add_run(length, font_id, color);
+    add_line();
+
+    advances.push_back(ax);
+    return {runs, advances, width, ay, ax, endy};
 }
 
-GraphicsGL::LayoutBuilder::LayoutBuilder(const Font& f,
-                                         Text::Alignment a,
-                                         std::int16_t mw,
-                                         bool fm)
-    : font(f), alignment(a), max_width(mw), formatted(fm)
+void GraphicsGL::LayoutBuilder::add(std::string_view text,
+                                    std::size_t first,
+                                    std::size_t last)
 {
-    font_id = Text::NUM_FONTS;
-    color = Text::NUM_COLORS;
-    ax = 0;
-    ay = font.line_space();
-    width = 0;
-    endy = 0;
-    if (max_width == 0) {
-        max_width = Window::get().get_width();
+    while (first < last) {
+        first = add_piece(text, first, last);
     }
 }
 
-std::string_view::size_type
-GraphicsGL::LayoutBuilder::add(std::string_view text,
-                               std::string_view::size_type prev,
-                               std::string_view::size_type first,
-                               std::string_view::size_type last)
+std::size_t GraphicsGL::LayoutBuilder::add_piece(std::string_view text,
+                                                 std::size_t first,
+                                                 std::size_t last)
 {
-    if (first == last) {
-        return prev;
-    }
-
     Text::Font last_font = font_id;
     Text::Color last_color = color;
-    std::string_view::size_type skip = 0;
+    std::size_t skip = 0;
     bool line_break = false;
     if (formatted) {
         switch (text[first]) {
@@ -552,47 +1205,55 @@ GraphicsGL::LayoutBuilder::add(std::string_view text,
         }
     }
 
+    // Cut the piece short before the first character which does not fit on
+    // a line. A character which is too wide on its own is kept, and ends up
+    // on a line of its own.
     std::int16_t word_width = 0;
     if (!line_break) {
-        for (std::string_view::size_type i = first; i < last; ++i) {
-            char c = text[i];
-            word_width += font.chars[static_cast<std::size_t>(c)].ax;
-
-            if (word_width > max_width) {
-                if (last - first == 1) {
-                    return last;
+        for (std::size_t i = first; i < last;) {
+            std::size_t start = i;
+            char32_t c = str::next_codepoint(text, i);
+            auto advance = glyphs->find(base_font, c).ax;
+            if (word_width + advance > max_width) {
+                if (start == first) {
+                    word_width += advance;
+                    last = i;
                 } else {
-                    prev = add(text, prev, first, i);
-                    return add(text, prev, i, last);
+                    last = start;
                 }
+                break;
             }
+
+            word_width += advance;
         }
     }
 
     bool new_word = skip > 0;
     bool new_line = line_break || ax + word_width > max_width;
     if (new_word || new_line) {
-        add_word(prev, first, last_font, last_color);
+        add_run(first, last_font, last_color);
     }
     if (new_line) {
         add_line();
 
         endy = ay;
         ax = 0;
-        ay += font.line_space();
+        ay += glyphs->line_space(base_font);
     }
 
-    for (std::string_view::size_type pos = first; pos < last; ++pos) {
-        char c = text[pos];
-        const Font::Char& ch = font.chars[static_cast<std::size_t>(c)];
+    for (std::size_t pos = first; pos < last;) {
+        std::size_t start = pos;
+        char32_t c = str::next_codepoint(text, pos);
 
-        advances.push_back(ax);
+        // Every byte of a character gets the same advance, so that the
+        // advances can still be looked up by position in the text.
+        advances.insert(advances.end(), pos - start, ax);
 
-        if (pos < first + skip || (new_line && c == ' ')) {
+        if (start < first + skip || (new_line && c == ' ')) {
             continue;
         }
 
-        ax += ch.ax;
+        ax += glyphs->find(base_font, c).ax;
 
         if (width < ax) {
             width = ax;
@@ -600,34 +1261,28 @@ GraphicsGL::LayoutBuilder::add(std::string_view text,
     }
 
     if (new_word || new_line) {
-        return first + skip;
-    } else {
-        return prev;
+        run_first = first + skip;
     }
-}
 
-Text::Layout GraphicsGL::LayoutBuilder::finish(std::size_t first,
-                                               std::size_t last)
-{
-    add_word(first, last, font_id, color);
-    add_line();
-
-    advances.push_back(ax);
-    return {lines, advances, width, ay, ax, endy};
+    return last;
 }
 
-void GraphicsGL::LayoutBuilder::add_word(std::size_t word_first,
-                                         std::size_t word_last,
-                                         Text::Font word_font,
-                                         Text::Color word_color)
+void GraphicsGL::LayoutBuilder::add_run(std::size_t last,
+                                        Text::Font run_font,
+                                        Text::Color run_color)
 {
-    words.push_back({word_first, word_last, word_font, word_color});
+    std::int16_t run_x = run_first < advances.size() ? advances[run_first] : 0;
+    runs.push_back({static_cast<std::uint32_t>(run_first),
+                    static_cast<std::uint32_t>(last),
+                    {run_x, 0},
+                    run_font,
+                    run_color,
+                    false});
 }
 
 void GraphicsGL::LayoutBuilder::add_line()
 {
     std::int16_t line_x = 0;
-    std::int16_t line_y = ay;
     switch (alignment) {
     case Text::CENTER:
         line_x -= ax / 2;
@@ -639,8 +1294,22 @@ void GraphicsGL::LayoutBuilder::add_line()
         break;
     }
 
-    lines.push_back({words, {line_x, line_y}});
-    words.clear();
+    for (std::size_t i = line_first; i < runs.size(); ++i) {
+        runs[i].position.shift_x(line_x);
+        runs[i].position.set_y(ay);
+    }
+
+    if (line_first < runs.size()) {
+        runs[line_first].line_start = true;
+    }
+    line_first = runs.size();
+}
+
+void GraphicsGL::warm_glyphs(std::string_view text, Text::Font font)
+{
+    for (std::size_t pos = 0; pos < text.size();) {
+        glyphs->use(font, str::next_codepoint(text, pos));
+    }
 }
 
 void GraphicsGL::draw_text(const DrawArgument& args,
@@ -648,7 +1317,8 @@ void GraphicsGL::draw_text(const DrawArgument& args,
                            const Text::Layout& layout,
                            Text::Font id,
                            Text::Color colorid,
-                           Text::Background background)
+                           Text::Background background,
+                           Text::QuadCache& cache)
 {
     if (locked) {
         return;
@@ -660,44 +1330,102 @@ void GraphicsGL::draw_text(const DrawArgument& args,
         return;
     }
 
-    const Font& font = fonts[id];
+    if (!cache.valid || cache.epoch != glyphs->get_epoch()) {
+        build_text(cache, text, layout, id, colorid, background);
+    }
+
+    for (std::uint32_t cell : cache.cells) {
+        glyphs->touch(cell);
+    }
 
     GLshort x = args.getpos().x();
     GLshort y = args.getpos().y();
+    const Quad::Rgba tint = color.to_bytes();
+    bool tinted = tint != Quad::Rgba{255, 255, 255, 255};
+
+    auto place = [&](Quad& quad, std::size_t index) {
+        quad.x0 += x;
+        quad.x1 += x;
+        quad.y0 += y;
+        quad.y1 += y;
+
+        if (tinted && index >= cache.background_count) {
+            for (std::size_t i = 0; i < Color::LENGTH; ++i) {
+                quad.color[i]
+                    = static_cast<GLubyte>(quad.color[i] * tint[i] / 255);
+            }
+        }
+    };
+
+    copy_quads(cache.quads.data(), cache.quads.size(), place);
+
+    if (recording) {
+        // Glyphs which are missing from the cached quads would stay missing
+        // from the recording.
+        if (!cache.valid) {
+            recording->valid = false;
+        }
+
+        recording->cells.insert(
+            recording->cells.end(), cache.cells.begin(), cache.cells.end());
+    }
+}
+
+void GraphicsGL::build_text(Text::QuadCache& cache,
+                            std::string_view text,
+                            const Text::Layout& layout,
+                            Text::Font id,
+                            Text::Color colorid,
+                            Text::Background background)
+{
+    cache.quads.clear();
+    cache.cells.clear();
+    cache.valid = true;
+
+    auto push = [&cache](const Quad& quad) {
+        std::memcpy(&cache.quads.emplace_back(), &quad, sizeof(Quad));
+    };
+
     GLshort w = layout.width();
     GLshort h = layout.height();
 
     switch (background) {
     case Text::NAMETAG:
-        for (const Text::Layout::Line& line : layout) {
-            GLshort left = x + line.position.x() - 2;
+        for (const Text::Layout::Run& run : layout) {
+            if (!run.line_start) {
+                continue;
+            }
+
+            GLshort left = run.position.x() - 2;
             GLshort right = left + w + 3;
-            GLshort top = y + line.position.y() - font.line_space() + 5;
+            GLshort top = run.position.y() - glyphs->line_space(id) + 5;
             GLshort bottom = top + h - 2;
-            Color ntcolor{0.0f, 0.0f, 0.0f, 0.6f};
-
-            quads.emplace_back(
-                left, right, top, bottom, null_offset, ntcolor, 0.0f);
-            quads.emplace_back(left - 1,
-                               left,
-                               top + 1,
-                               bottom - 1,
-                               null_offset,
-                               ntcolor,
-                               0.0f);
-            quads.emplace_back(right,
-                               right + 1,
-                               top + 1,
-                               bottom - 1,
-                               null_offset,
-                               ntcolor,
-                               0.0f);
+            constexpr const Quad::Rgba ntcolor
+                = Color{0.0f, 0.0f, 0.0f, 0.6f}.to_bytes();
+
+            push(Quad(left, right, top, bottom, null_offset, ntcolor, 0.0f));
+            push(Quad(left - 1,
+                      left,
+                      top + 1,
+                      bottom - 1,
+                      null_offset,
+                      ntcolor,
+                      0.0f));
+            push(Quad(right,
+                      right + 1,
+                      top + 1,
+                      bottom - 1,
+                      null_offset,
+                      ntcolor,
+                      0.0f));
         }
         break;
     default:
         break;
     }
 
+    cache.background_count = cache.quads.size();
+
     static constexpr const GLfloat colors[Text::NUM_COLORS][3] = {
         {0.0f, 0.0f, 0.0f},    // Black
         {1.0f, 1.0f, 1.0f},    // White
@@ -713,47 +1441,53 @@ void GraphicsGL::draw_text(const DrawArgument& args,
         {0.5f, 0.0f, 0.5f}     // Violet
     };
 
-    for (const Text::Layout::Line& line : layout) {
-        Point<std::int16_t> position = line.position;
+    for (const Text::Layout::Run& run : layout) {
+        GLshort ax = run.position.x();
+        GLshort ay = run.position.y();
 
-        for (const Text::Layout::Word& word : line.words) {
-            GLshort ax = position.x() + layout.advance(word.first);
-            GLshort ay = position.y();
+        const GLfloat* runcolor;
+        if (run.color < Text::NUM_COLORS) {
+            runcolor = colors[run.color];
+        } else {
+            runcolor = colors[colorid];
+        }
+        const Quad::Rgba abscolor
+            = Color{runcolor[0], runcolor[1], runcolor[2], 1.0f}.to_bytes();
 
-            const GLfloat* wordcolor;
-            if (word.color < Text::NUM_COLORS) {
-                wordcolor = colors[word.color];
-            } else {
-                wordcolor = colors[colorid];
+        for (std::size_t pos = run.first; pos < run.last;) {
+            const char32_t c = str::next_codepoint(text, pos);
+            if (ax == 0 && c == ' ') {
+                continue;
             }
-            Color abscolor
-                = color
-                  * Color{wordcolor[0], wordcolor[1], wordcolor[2], 1.0f};
-
-            for (std::size_t pos = word.first; pos < word.last; ++pos) {
-                const char c = text[pos];
-                const Font::Char& ch = font.chars[static_cast<std::size_t>(c)];
 
-                GLshort chx = x + ax + ch.bl;
-                GLshort chy = y + ay - ch.bt;
-                GLshort chw = ch.bw;
-                GLshort chh = ch.bh;
+            const GlyphCache::Glyph& ch = glyphs->use(id, c);
 
-                if (ax == 0 && c == ' ') {
-                    continue;
-                }
+            GLshort chx = ax + ch.bl;
+            GLshort chy = ay - ch.bt;
+            GLshort chw = ch.bw;
+            GLshort chh = ch.bh;
 
-                ax += ch.ax;
+            ax += ch.ax;
 
-                if (chw <= 0 || chh <= 0) {
-                    continue;
+            if (ch.cell == GlyphCache::NO_CELL) {
+                // Every cell is taken by text drawn in this frame. Try
+                // again next frame rather than keep the gap.
+                if (!ch.blank) {
+                    cache.valid = false;
                 }
 
-                quads.emplace_back(
-                    chx, chx + chw, chy, chy + chh, ch.offset, abscolor, 0.0f);
+                continue;
             }
+
+            push(Quad(
+                chx, chx + chw, chy, chy + chh, ch.offset, abscolor, 0.0f));
+            cache.cells.push_back(ch.cell);
         }
     }
+
+    // Glyphs rasterised above may have evicted others, which the quads do
+    // not use.
+    cache.epoch = glyphs->get_epoch();
 }
 
 void GraphicsGL::draw_rectangle(std::int16_t x,
@@ -769,8 +1503,8 @@ void GraphicsGL::draw_rectangle(std::int16_t x,
         return;
     }
 
-    quads.emplace_back(
-        x, x + w, y, y + h, null_offset, Color{r, g, b, a}, 0.0f);
+    emplace_quad(
+        x, x + w, y, y + h, null_offset, Color{r, g, b, a}.to_bytes(), 0.0f);
 }
 
 void GraphicsGL::draw_screen_fill(float r, float g, float b, float a)
@@ -797,44 +1531,100 @@ void GraphicsGL::unlock()
 
 void GraphicsGL::flush(float opacity)
 {
-    bool coverscene = opacity != 1.0f;
-    if (coverscene) {
-        float complement = 1.0f - opacity;
-        Color color{0.0f, 0.0f, 0.0f, complement};
+    Profiler::Scope scope{"GraphicsGL::flush"};
 
-        quads.emplace_back(screen.l(),
-                           screen.r(),
-                           screen.t(),
-                           screen.b(),
-                           null_offset,
-                           color,
-                           0.0f);
+    if (core_profile) {
+        close_run();
     }
 
-    glClearColor(1.0, 1.0, 1.0, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT);
+    // Composites whose slot was taken by something else in the meantime
+    // are not worth rendering. Nor are those whose parts were evicted, as
+    // the parts may have been overwritten. Those are dropped from the
+    // cache as well, so that they are not drawn wrong until the look
+    // changes.
+    auto stale = [&](const CompositeJob& job) {
+        if (slots[job.slot].generation != job.generation) {
+            return true;
+        }
+
+        auto first = composite_sources.begin() + job.first_source;
+        bool evicted = std::any_of(
+            first, first + job.source_count, [&](const AtlasHandle& source) {
+                return slots[source.slot].generation != source.generation;
+            });
+        if (evicted) {
+            release_slot(job.slot);
+        }
+
+        return evicted;
+    };
+    composite_jobs.erase(
+        std::remove_if(composite_jobs.begin(), composite_jobs.end(), stale),
+        composite_jobs.end());
+
+    backend->flush({batches, commands, composite_jobs, opacity});
+    composite_jobs.clear();
+    composite_sources.clear();
+}
+
+bool GraphicsGL::start_rendering(std::function<void(bool)> make_current,
+                                 std::function<void()> present)
+{
+    return backend->start(std::move(make_current), std::move(present));
+}
 
-    GLsizei csize = static_cast<GLsizei>(quads.size() * sizeof(Quad));
-    GLsizei fsize = static_cast<GLsizei>(quads.size() * Quad::LENGTH);
-    glEnableVertexAttribArray(attribute_coord);
-    glEnableVertexAttribArray(attribute_color);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, csize, quads.data(), GL_STREAM_DRAW);
-    glDrawArrays(GL_QUADS, 0, fsize);
+void GraphicsGL::stop_rendering()
+{
+    backend->stop();
+}
 
-    glDisableVertexAttribArray(attribute_coord);
-    glDisableVertexAttribArray(attribute_color);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+bool GraphicsGL::wait_ready(std::chrono::microseconds timeout)
+{
+    return backend->wait_ready(timeout);
+}
 
-    if (coverscene) {
-        quads.pop_back();
+void GraphicsGL::close_run()
+{
+    std::size_t size = stream.size();
+    if (size > run_start) {
+        commands.push_back({0,
+                            static_cast<GLint>(run_start),
+                            static_cast<GLsizei>(size - run_start),
+                            {}});
+        run_start = size;
     }
 }
 
 void GraphicsGL::clearscene()
 {
+    // Make room for what did not fit in the last frame, while nothing
+    // refers to the atlas.
+    if (atlas_full) {
+        GLushort oldest = 0;
+        for (GLushort i = 1; i < pages.size(); ++i) {
+            if (pages[i].last_used < pages[oldest].last_used) {
+                oldest = i;
+            }
+        }
+
+        evict(oldest);
+        atlas_full = false;
+    }
+
+    upload_bitmaps();
+
     if (!locked) {
-        quads.clear();
+        stream.begin();
+        batches.clear();
+        commands.clear();
+        run_start = 0;
+        ++frame;
+        glyphs->begin_frame();
+
+        if (!static_garbage.empty()) {
+            backend->delete_static(static_garbage);
+            static_garbage.clear();
+        }
     }
 }
 
@@ -850,4 +1640,46 @@ void GraphicsGL::set_screen(std::int16_t l,
 {
     screen = {l, r, t, b};
 }
+
+const Rectangle<std::int16_t>& GraphicsGL::get_screen() noexcept
+{
+    return screen;
+}
+
+const StreamBuffer::Stats& GraphicsGL::get_stream_stats() const noexcept
+{
+    return stream.get_stats();
+}
+
+const GraphicsGL::AtlasStats& GraphicsGL::get_atlas_stats() const noexcept
+{
+    return atlas_stats;
+}
+
+const GraphicsGL::UploadStats& GraphicsGL::get_upload_stats() const noexcept
+{
+    return upload_stats;
+}
+
+const GraphicsGL::CompositeStats&
+GraphicsGL::get_composite_stats() const noexcept
+{
+    return composite_stats;
+}
+
+const GraphicsGL::GlyphStats& GraphicsGL::get_glyph_stats() const noexcept
+{
+    return glyphs->get_stats();
+}
+
+const GraphicsGL::RetainedStats&
+GraphicsGL::get_retained_stats() const noexcept
+{
+    return retained_stats;
+}
+
+const GraphicsGL::Recording* GraphicsGL::get_recording() const noexcept
+{
+    return backend ? backend->recording() : nullptr;
+}
 } // namespace jrc
@@ -20,16 +20,29 @@
 #include "../Error.h"
 #include "../Template/Rectangle.h"
 #include "../Template/Singleton.h"
-#include "../Util/QuadTree.h"
+#include "AtlasHandle.h"
+#include "AtlasPacker.h"
+#include "BitmapLoader.h"
 #include "DrawArgument.h"
 #include "GL/glew.h"
+#include "RetainedQuads.h"
+#include "StaticBatch.h"
+#include "StreamBuffer.h"
 #include "Text.h"
 #include "ft2build.h"
 #include "nlnx/bitmap.hpp"
 #include FT_FREETYPE_H
 
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
 #include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace jrc
@@ -39,22 +52,86 @@ class GraphicsGL : public Singleton<GraphicsGL>
 {
 public:
     GraphicsGL();
+    ~GraphicsGL() override;
 
-    //! Initialise all resources.
-    Error init();
+    //! Initialise all resources. A headless engine keeps track of the atlas
+    //! and of everything drawn as usual, but does not use OpenGL at all.
+    Error init(bool headless);
+    //! Stop loading bitmaps and drawing in the background.
+    void close();
     //! Re-initialise after changing screen modes.
     void reinit();
 
     //! Clear all bitmaps if most of the space is used up.
     void clear();
 
-    //! Add a bitmap to the available resources.
-    void add_bitmap(const nl::bitmap& bmp);
-    //! Draw the bitmap with the given parameters.
+    //! Add a bitmap to the available resources, and update the handle to
+    //! refer to it.
+    void add_bitmap(const nl::bitmap& bmp, AtlasHandle& handle);
+    //! Draw the bitmap with the given parameters. The handle is used to find
+    //! the bitmap in the atlas, and updated if it is out of date.
     void draw(const nl::bitmap& bmp,
+              AtlasHandle& handle,
               const Rectangle<std::int16_t>& rect,
               const Color& color,
               float angle);
+    //! Draw the bitmap `count` times in each direction, with the copies
+    //! `period` pixels apart, starting with the given rectangle. On the
+    //! core profile path this is a single quad, unless the copies overlap.
+    void draw_tiled(const nl::bitmap& bmp,
+                    AtlasHandle& handle,
+                    const Rectangle<std::int16_t>& rect,
+                    const Color& color,
+                    Point<std::int16_t> period,
+                    Point<std::int16_t> count);
+    //! Draw a static batch, shifted by the given offset.
+    void draw_static(const StaticBatch& batch, Point<std::int16_t> offset);
+    //! Delete the vertex buffer of a static batch, and allow the bitmaps in
+    //! it to be evicted again.
+    void release_static(const StaticBatch& batch);
+
+    //! Identifies a composite: a group of draws, such as the layers of a
+    //! character, which is rendered into the atlas once and then drawn as a
+    //! single quad.
+    struct CompositeKey {
+        //! A hash of everything the composite is made of, shared by all
+        //! poses.
+        std::uint64_t look;
+        std::uint64_t pose;
+
+        bool operator==(const CompositeKey& other) const noexcept
+        {
+            return look == other.look && pose == other.pose;
+        }
+    };
+
+    //! Draw a composite at the given position. Returns `false` if it is not
+    //! in the atlas, in which case it should be drawn between
+    //! `begin_composite` and `end_composite`.
+    bool draw_composite(const CompositeKey& key,
+                        Point<std::int16_t> pos,
+                        const Color& color);
+    //! Start capturing draws for a composite.
+    void begin_composite();
+    //! Stop capturing, and draw the captured draws with the given color.
+    //! They are rendered into the atlas at the end of the frame, unless
+    //! some of the bitmaps were still loading. Composites which are no
+    //! longer drawn, such as those of a look that changed, are left to age
+    //! out of the atlas, as other characters may share the look.
+    void end_composite(const CompositeKey& key,
+                       Point<std::int16_t> pos,
+                       const Color& color);
+
+    //! Draw the recorded quads of a retained group, shifted by the distance
+    //! between the given position and where the group was recorded. Returns
+    //! `false` if they are out of date, in which case the group should be
+    //! drawn between `begin_retained` and `end_retained`.
+    bool draw_retained(RetainedQuads& retained, Point<std::int16_t> pos);
+    //! Start recording the quads of everything drawn into a retained group.
+    void begin_retained(RetainedQuads& retained);
+    //! Stop recording. The recording is only kept if everything drawn was
+    //! in the atlas.
+    void end_retained(RetainedQuads& retained, Point<std::int16_t> pos);
 
     //! Create a layout for the text with the parameters specified.
     Text::Layout create_layout(std::string_view text,
@@ -62,13 +139,17 @@ public:
                                Text::Alignment alignment,
                                std::int16_t max_width,
                                bool formatted);
-    //! Draw a text with the given parameters.
+    //! Rasterise the glyphs of a text ahead of drawing it.
+    void warm_glyphs(std::string_view text, Text::Font font);
+    //! Draw a text with the given parameters. The quads of the text are
+    //! kept in the cache, and only built again when they are stale.
     void draw_text(const DrawArgument& args,
                    std::string_view text,
                    const Text::Layout& layout,
                    Text::Font font,
                    Text::Color color,
-                   Text::Background back);
+                   Text::Background back,
+                   Text::QuadCache& cache);
 
     //! Draw a rectangle filled with the specified color.
     void draw_rectangle(std::int16_t x,
@@ -87,8 +168,23 @@ public:
     //! Unlock the scene.
     void unlock();
 
-    //! Draw the buffer contents with the specified scene opacity.
+    //! Draw the buffer contents with the specified scene opacity. With a
+    //! render thread, the frame is handed to it instead.
     void flush(float opacity);
+    //! Start drawing on a render thread, if the configuration asks for one.
+    //! The thread makes the context current by calling `make_current` with
+    //! `true`, and releases it with `false` before it exits. It calls
+    //! `present` after every frame. Returns `false` if there is no render
+    //! thread, in which case drawing stays on the calling thread.
+    bool start_rendering(std::function<void(bool)> make_current,
+                         std::function<void()> present);
+    //! Wait for the render thread to finish all frames and exit, so that the
+    //! context can be used from the calling thread again.
+    void stop_rendering();
+    //! Wait until the render thread is ready for another frame, for at most
+    //! the given time. Returns `false` if it is still busy, in which case
+    //! the frame should be skipped rather than drawn.
+    bool wait_ready(std::chrono::microseconds timeout);
     //! Clear the buffer contents.
     void clearscene();
     //! Set the screen rectangle.
@@ -98,24 +194,109 @@ public:
                            std::int16_t r,
                            std::int16_t t,
                            std::int16_t b) noexcept;
+    //! Return the screen rectangle. Anything outside of it is not drawn.
+    static const Rectangle<std::int16_t>& get_screen() noexcept;
+
+    //! Counters for atlas lookups since startup.
+    struct AtlasStats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        //! Bitmaps evicted, including those on evicted pages.
+        std::uint64_t evictions = 0;
+        std::uint64_t page_evictions = 0;
+    };
+
+    //! Counters for bitmap uploads to the atlas.
+    struct UploadStats {
+        //! Bitmaps which are being decompressed or waiting to be uploaded.
+        std::size_t queue_depth = 0;
+        std::size_t frame_bytes = 0;
+        std::uint64_t total_bytes = 0;
+        std::uint64_t uploads = 0;
+        //! Frames in which the uploads took longer than the time budget, or
+        //! a single bitmap was larger than the byte budget.
+        std::uint64_t overruns = 0;
+    };
+
+    //! Return the vertex upload counters.
+    const StreamBuffer::Stats& get_stream_stats() const noexcept;
+    //! Return the atlas residency counters.
+    const AtlasStats& get_atlas_stats() const noexcept;
+    //! Counters for composite lookups since startup.
+    struct CompositeStats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        //! Composites evicted to stay within the size of the cache.
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+    };
+
+    //! Counters for the work a headless engine would have sent to the GPU.
+    struct Recording {
+        std::uint64_t frames = 0;
+        std::uint64_t draw_calls = 0;
+        std::uint64_t quads = 0;
+        std::uint64_t uploads = 0;
+        std::uint64_t upload_bytes = 0;
+        //! Vertex buffers of static batches which currently exist.
+        std::size_t static_buffers = 0;
+        std::uint64_t composites = 0;
+    };
+
+    //! Counters for the glyph cache since startup.
+    struct GlyphStats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        //! Glyphs whose metrics are known, whether in the atlas or not.
+        std::size_t entries = 0;
+        //! Time spent rasterising glyphs in the current frame.
+        std::chrono::microseconds frame_time{0};
+        //! The most time spent rasterising glyphs in a single frame.
+        std::chrono::microseconds worst_frame_time{0};
+    };
+
+    //! Counters for the quads of retained groups since startup.
+    struct RetainedStats {
+        //! Quads copied from a recording.
+        std::uint64_t replayed = 0;
+        //! Quads drawn while recording, because nothing was recorded yet or
+        //! the recording was out of date.
+        std::uint64_t rebuilt = 0;
+    };
+
+    //! Return the bitmap upload counters.
+    const UploadStats& get_upload_stats() const noexcept;
+    //! Return the composite cache counters.
+    const CompositeStats& get_composite_stats() const noexcept;
+    //! Return the glyph cache counters.
+    const GlyphStats& get_glyph_stats() const noexcept;
+    //! Return the retained group counters.
+    const RetainedStats& get_retained_stats() const noexcept;
+    //! Return the recording counters, or `nullptr` if the engine is not
+    //! headless.
+    const Recording* get_recording() const noexcept;
 
 private:
     void clear_internal();
-    bool
-    addfont(const char* name, Text::Font id, FT_UInt width, FT_UInt height);
 
     struct Offset {
         GLshort l;
         GLshort r;
         GLshort t;
         GLshort b;
+        GLushort page;
+        //! The last frame in which the bitmap was used.
+        std::uint64_t last_used;
 
-        Offset(GLshort x, GLshort y, GLshort w, GLshort h)
+        Offset(GLshort x, GLshort y, GLshort w, GLshort h, GLushort p)
         {
             l = x;
             r = x + w;
             t = y;
             b = y + h;
+            page = p;
+            last_used = 0;
         }
 
         Offset()
@@ -124,77 +305,173 @@ private:
             r = 0;
             t = 0;
             b = 0;
+            page = 0;
+            last_used = 0;
         }
     };
-    //! Add a bitmap to the available resources.
-    const Offset& get_offset(const nl::bitmap& bmp);
-
-    struct Leftover {
-        GLshort l;
-        GLshort r;
-        GLshort t;
-        GLshort b;
-
-        Leftover(GLshort x, GLshort y, GLshort w, GLshort h)
-        {
-            l = x;
-            r = x + w;
-            t = y;
-            b = y + h;
-        }
-
-        Leftover()
-        {
-            l = 0;
-            r = 0;
-            t = 0;
-            b = 0;
-        }
-
-        GLshort width() const
-        {
-            return r - l;
-        }
+    //! Find a bitmap in the atlas, and queue it for loading if it is not
+    //! there. Returns `nullptr` while the bitmap is still being loaded.
+    const Offset* get_offset(const nl::bitmap& bmp, AtlasHandle& handle);
+    //! Upload bitmaps which have finished loading, until the budget for the
+    //! frame runs out. Bitmaps which were drawn while they were loading go
+    //! first.
+    void upload_bitmaps();
+
+    //! An entry in the table of bitmaps in the atlas. Slots are reused, and
+    //! the generation changes whenever a slot is freed.
+    struct Slot {
+        Offset offset;
+        //! The id of the bitmap, or zero if the slot is free.
+        std::size_t id;
+        std::uint32_t generation;
+        //! Whether the pixels have been uploaded yet.
+        bool resident;
+        //! The last frame in which the bitmap was drawn before it was
+        //! resident.
+        std::uint64_t wanted;
+        //! Static batches whose vertex buffer refers to the bitmap.
+        std::uint32_t pins;
+        //! Whether the slot holds a composite instead of a bitmap.
+        bool composite;
+        //! Neighbours in the list of slots in use, or `NO_SLOT`.
+        std::uint32_t lru_prev;
+        std::uint32_t lru_next;
+    };
 
-        GLshort height() const
-        {
-            return b - t;
-        }
+    //! Count a hit on a slot, and mark it as used in the current frame.
+    const Offset* use_slot(std::uint32_t index);
+    //! Mark a slot as used in the current frame.
+    void touch_slot(std::uint32_t index);
+    //! Add a slot which has just been filled as the most recently used.
+    void link_slot(std::uint32_t index);
+    //! Take a slot out of the list of slots in use.
+    void unlink_slot(std::uint32_t index);
+    //! Take an unused slot.
+    std::uint32_t new_slot();
+    //! Forget the bitmap in a slot, and make the slot available again.
+    void free_slot(std::uint32_t index);
+    //! Give back the space the bitmap in a slot takes up in the atlas.
+    void unplace_slot(std::uint32_t index);
+    //! Free a slot and the space its bitmap takes up in the atlas.
+    void release_slot(std::uint32_t index);
+
+    //! One page of the texture atlas. Pages are packed independently of each
+    //! other, so that a full page can be evicted without touching the rest.
+    struct Page {
+        AtlasPacker packer{ATLASW, ATLASH, MINLOSIZE};
+        //! Slots of the bitmaps stored on this page.
+        std::vector<std::uint32_t> bitmaps;
+        //! The last frame in which a bitmap on this page was used.
+        std::uint64_t last_used;
+
+        //! Forget everything on the page, leaving rows above `top` alone.
+        void reset(GLshort top);
     };
 
+    //! Find space for a bitmap of the given size, evicting older bitmaps if
+    //! there is not enough. Bitmaps used in the current frame are never
+    //! evicted, so this fails if every page is in use. The least recently
+    //! used page is then evicted before the next frame, and the bitmap has
+    //! to wait until then.
+    bool allocate(GLshort w, GLshort h, GLushort& page, Point<GLshort>& pos);
+    //! Let the upload scheduler know that a bitmap is needed on screen.
+    void want(const AtlasHandle& handle);
+    //! Evict the least recently used bitmap which is at least as large as
+    //! the given size, and place a bitmap in the space it leaves. Only
+    //! bitmaps not used in the current frame are looked at, oldest first.
+    bool evict_region(GLshort w,
+                      GLshort h,
+                      GLushort& page,
+                      Point<GLshort>& pos);
+    //! Evict all bitmaps on a page.
+    void evict(GLushort page);
+    //! Copy pixels into the atlas.
+    void upload(GLushort page,
+                GLshort x,
+                GLshort y,
+                GLshort w,
+                GLshort h,
+                GLenum format,
+                const void* pixels);
+
+    //! A textured, coloured and possibly rotated rectangle. Mirroring and
+    //! scaling are already part of the rectangle, whose edges are swapped
+    //! when it is flipped.
+    //!
+    //! The core profile renderer streams quads as they are, as per-instance
+    //! attributes, and builds the corners in the vertex shader. The legacy
+    //! renderer expands every quad into vertices on the CPU, and draws runs
+    //! of quads from the same atlas page in separate batches.
+    //!
+    //! With a non-zero period, which only the core profile renderer
+    //! supports, the texture is repeated across the quad instead of being
+    //! stretched. The texture rectangle then describes a single copy.
     struct Quad {
+        using Rgba = std::array<GLubyte, Color::LENGTH>;
+
         struct Vertex {
             GLshort x;
             GLshort y;
-            GLshort s;
-            GLshort t;
+            GLushort s;
+            GLushort t;
 
-            Color c;
+            Rgba c;
         };
 
         static const std::size_t LENGTH = 4;
-        Vertex vertices[LENGTH];
+
+        GLshort x0;
+        GLshort x1;
+        GLshort y0;
+        GLshort y1;
+        GLushort s0;
+        GLushort s1;
+        GLushort t0;
+        GLushort t1;
+        Rgba color;
+        GLfloat angle;
+        GLushort page;
+        GLshort period_x;
+        GLshort period_y;
 
         Quad(GLshort l,
              GLshort r,
              GLshort t,
              GLshort b,
              const Offset& o,
-             const Color& color,
+             const Rgba& c,
              GLfloat rot)
         {
-            vertices[0] = {l, t, o.l, o.t, color};
-            vertices[1] = {l, b, o.l, o.b, color};
-            vertices[2] = {r, b, o.r, o.b, color};
-            vertices[3] = {r, t, o.r, o.t, color};
-
-            if (rot != 0.0f) {
-                float cos = std::cos(rot);
-                float sin = std::sin(rot);
-                GLshort cx = (l + r) / 2;
-                GLshort cy = (t + b) / 2;
-
-                for (int i = 0; i < 4; ++i) {
+            x0 = l;
+            x1 = r;
+            y0 = t;
+            y1 = b;
+            s0 = static_cast<GLushort>(o.l);
+            s1 = static_cast<GLushort>(o.r);
+            t0 = static_cast<GLushort>(o.t);
+            t1 = static_cast<GLushort>(o.b);
+            color = c;
+            angle = rot;
+            page = o.page;
+            period_x = 0;
+            period_y = 0;
+        }
+
+        //! Write the four corners of the quad, for the legacy renderer.
+        void expand(Vertex* vertices) const
+        {
+            vertices[0] = {x0, y0, s0, t0, color};
+            vertices[1] = {x0, y1, s0, t1, color};
+            vertices[2] = {x1, y1, s1, t1, color};
+            vertices[3] = {x1, y0, s1, t0, color};
+
+            if (angle != 0.0f) {
+                float cos = std::cos(angle);
+                float sin = std::sin(angle);
+                GLshort cx = (x0 + x1) / 2;
+                GLshort cy = (y0 + y1) / 2;
+
+                for (std::size_t i = 0; i < LENGTH; ++i) {
                     GLshort vx = vertices[i].x - cx;
                     GLshort vy = vertices[i].y - cy;
                     GLfloat rx = std::roundf(vx * cos - vy * sin);
@@ -206,62 +483,261 @@ private:
         }
     };
 
-    struct Font {
-        struct Char {
-            GLshort ax;
-            GLshort ay;
-            GLshort bw;
-            GLshort bh;
-            GLshort bl;
-            GLshort bt;
-            Offset offset;
-        };
+    static_assert(sizeof(Quad::Vertex) == 12,
+                  "Vertices must stay tightly packed for streaming.");
+    static_assert(sizeof(Quad) == 32,
+                  "Quads must stay tightly packed for streaming.");
 
-        GLshort width;
-        GLshort height;
-        Char chars[128];
+    //! Append a quad to the current frame. Quads which do not fit into the
+    //! stream buffer are dropped.
+    template<typename... Args>
+    void emplace_quad(Args&&... args)
+    {
+        void* dest = stream.next();
+        if (!dest) {
+            if (recording) {
+                recording->valid = false;
+            }
+
+            return;
+        }
+
+        if (core_profile) {
+            auto quad = new (dest) Quad(std::forward<Args>(args)...);
+            if (recording) {
+                record(*quad);
+            }
+        } else {
+            Quad quad(std::forward<Args>(args)...);
+            quad.expand(static_cast<Quad::Vertex*>(dest));
+            add_to_batch(quad);
+            if (recording) {
+                record(quad);
+            }
+        }
+    }
+
+    //! Append quads which were copied out of the stream before, after
+    //! passing each of them to `modify` along with its index.
+    template<typename Modify>
+    void copy_quads(const void* source, std::size_t count, Modify&& modify)
+    {
+        if (core_profile) {
+            // The quads go into the stream at once, or not at all.
+            auto dest = static_cast<Quad*>(stream.next(count));
+            if (!dest) {
+                if (recording) {
+                    recording->valid = false;
+                }
+
+                return;
+            }
 
-        Font(GLshort w, GLshort h)
+            std::memcpy(
+                static_cast<void*>(dest), source, count * sizeof(Quad));
+            for (std::size_t i = 0; i < count; ++i) {
+                modify(dest[i], i);
+                if (recording) {
+                    record(dest[i]);
+                }
+            }
+        } else {
+            auto bytes = static_cast<const std::uint8_t*>(source);
+            for (std::size_t i = 0; i < count; ++i) {
+                Quad quad{0, 0, 0, 0, null_offset, {}, 0.0f};
+                std::memcpy(static_cast<void*>(&quad),
+                            bytes + i * sizeof(Quad),
+                            sizeof(Quad));
+                modify(quad, i);
+                emplace_quad(quad);
+            }
+        }
+    }
+
+    //! Add a quad to the retained group being recorded.
+    void record(const Quad& quad);
+
+    //! A run of consecutive quads which sample from the same atlas page.
+    struct Batch {
+        GLushort page;
+        GLint first;
+        GLsizei count;
+    };
+
+    //! Extend the last batch with the quad just written, or start a new one.
+    void add_to_batch(const Quad& quad);
+
+    static_assert(sizeof(Text::QuadCache::Quad) == sizeof(Quad),
+                  "Cached text quads must match the quads of the stream.");
+    static_assert(sizeof(RetainedQuads::Quad) == sizeof(Quad),
+                  "Retained quads must match the quads of the stream.");
+
+    //! Build the quads of a text, as if it was drawn at the origin in an
+    //! opaque white.
+    void build_text(Text::QuadCache& cache,
+                    std::string_view text,
+                    const Text::Layout& layout,
+                    Text::Font font,
+                    Text::Color color,
+                    Text::Background back);
+
+    //! A range of instances to draw on the core profile path, either from
+    //! the stream or from the vertex buffer of a static batch.
+    struct Command {
+        //! The vertex buffer, or zero for the stream.
+        GLuint buffer;
+        GLint first;
+        GLsizei count;
+        Point<std::int16_t> offset;
+    };
+
+    //! End the current run of streamed quads, so that a static batch can be
+    //! drawn after it.
+    void close_run();
+    //! Build the vertex buffer of a static batch. Returns `false` if some of
+    //! the bitmaps are still being loaded.
+    bool build_static(const StaticBatch& batch);
+
+    struct CompositeHash {
+        std::size_t operator()(const CompositeKey& key) const noexcept
         {
-            width = w;
-            height = h;
+            return std::hash<std::uint64_t>{}(key.look * 31 + key.pose);
         }
+    };
 
-        Font()
+    struct Composite {
+        std::uint32_t slot;
+        std::uint32_t generation;
+        //! The area covered by the composite, relative to where it is drawn.
+        Rectangle<std::int16_t> bounds;
+    };
+
+    //! A composite which still has to be rendered into the atlas. Its quads
+    //! are in the stream, but not part of any command.
+    struct CompositeJob {
+        std::uint32_t slot;
+        std::uint32_t generation;
+        //! Where the composite goes in the atlas.
+        Offset offset;
+        GLint first;
+        GLsizei count;
+        //! The top left corner of the quads on the screen.
+        Point<std::int16_t> origin;
+        //! The bitmaps the quads sample from, in `composite_sources`.
+        std::uint32_t first_source;
+        std::uint32_t source_count;
+    };
+
+    //! Everything drawn in a frame, besides the quads in the stream.
+    struct Frame {
+        const std::vector<Batch>& batches;
+        const std::vector<Command>& commands;
+        //! Composites to render into the atlas before drawing. Their slots
+        //! are all still valid.
+        const std::vector<CompositeJob>& composite_jobs;
+        float opacity;
+    };
+
+    //! Evict the least recently used composites until there is room for a
+    //! new one.
+    void trim_composites();
+
+    //! Everything which talks to the GPU. The engine does all of the
+    //! bookkeeping for the atlas and the frame, and hands the results to
+    //! the backend to upload and draw. Backends draw the quads of the
+    //! stream they were created with.
+    class Backend
+    {
+    public:
+        virtual ~Backend() = default;
+
+        //! Create the atlas and everything needed to draw, and initialise
+        //! the stream. Decides whether the core profile is used, and how
+        //! many atlas pages there are.
+        virtual Error init(GraphicsGL& gl, GLushort& page_count) = 0;
+        //! Set up the state of a new context or screen size.
+        virtual void reinit(GraphicsGL& gl) = 0;
+
+        //! Copy pixels into the atlas.
+        virtual void upload(GLushort page,
+                            GLshort x,
+                            GLshort y,
+                            GLshort w,
+                            GLshort h,
+                            GLenum format,
+                            const void* pixels) = 0;
+        //! Prepare for uploading the bitmaps of a frame.
+        virtual void begin_uploads() = 0;
+        //! Copy the pixels of a decompressed bitmap into its place in the
+        //! atlas.
+        virtual void upload_bitmap(const Offset& offset,
+                                   const std::uint8_t* pixels,
+                                   std::size_t size)
+            = 0;
+        //! Finish uploading the bitmaps of a frame.
+        virtual void end_uploads() = 0;
+
+        //! Create a vertex buffer holding the given quads.
+        virtual GLuint create_static(const Quad* quads, std::size_t count)
+            = 0;
+        //! Delete vertex buffers created with `create_static`.
+        virtual void delete_static(const std::vector<GLuint>& buffers) = 0;
+
+        //! Render the pending composites and draw the frame.
+        virtual void flush(const Frame& frame) = 0;
+
+        //! See `GraphicsGL::start_rendering`.
+        virtual bool start(std::function<void(bool)>, std::function<void()>)
         {
-            width = 0;
-            height = 0;
+            return false;
+        }
+        //! See `GraphicsGL::stop_rendering`.
+        virtual void stop()
+        {
+        }
+        //! See `GraphicsGL::wait_ready`.
+        virtual bool wait_ready(std::chrono::microseconds)
+        {
+            return true;
         }
 
-        std::int16_t line_space() const
+        virtual const Recording* recording() const noexcept
         {
-            return static_cast<std::int16_t>(height * 1.35 + 1);
+            return nullptr;
         }
     };
 
+    class GLBackend;
+    class RecordingBackend;
+    class ThreadedBackend;
+    class GlyphCache;
+
+    //! Lays out texts. A single builder is reused for every layout, so that
+    //! its buffers stop growing after the first few texts.
     class LayoutBuilder
     {
     public:
-        LayoutBuilder(const Font& font,
-                      Text::Alignment alignment,
-                      std::int16_t maxwidth,
-                      bool formatted);
-
-        std::string_view::size_type add(std::string_view text,
-                                        std::string_view::size_type prev,
-                                        std::string_view::size_type first,
-                                        std::string_view::size_type last);
-        Text::Layout finish(std::size_t first, std::size_t last);
+        Text::Layout build(GlyphCache& glyphs,
+                           std::string_view text,
+                           Text::Font font,
+                           Text::Alignment alignment,
+                           std::int16_t max_width,
+                           bool formatted);
 
     private:
-        void add_word(std::size_t first,
-                      std::size_t last,
-                      Text::Font font,
-                      Text::Color color);
+        //! Add the bytes from one separator to the next, split into pieces
+        //! which fit on a line.
+        void add(std::string_view text, std::size_t first, std::size_t last);
+        //! Add as much of the bytes as fits on a line, and return where the
+        //! next piece starts.
+        std::size_t
+        add_piece(std::string_view text, std::size_t first, std::size_t last);
+        //! End the current run at the given byte.
+        void add_run(std::size_t last, Text::Font font, Text::Color color);
         void add_line();
 
-        const Font& font;
-
+        GlyphCache* glyphs;
+        Text::Font base_font;
         Text::Alignment alignment;
         Text::Font font_id;
         Text::Color color;
@@ -270,47 +746,92 @@ private:
 
         std::int16_t ax;
         std::int16_t ay;
-
-        std::vector<Text::Layout::Line> lines;
-        std::vector<Text::Layout::Word> words;
-        std::vector<std::int16_t> advances;
         std::int16_t width;
         std::int16_t endy;
+        //! The first byte of the current run.
+        std::size_t run_first;
+        //! The first run of the current line.
+        std::size_t line_first;
+
+        std::vector<Text::Layout::Run> runs;
+        std::vector<std::int16_t> advances;
     };
 
     static Rectangle<std::int16_t> screen;
 
     static const GLshort ATLASW = 8192;
     static const GLshort ATLASH = 8192;
-    static const GLshort MINLOSIZE = 32;
+    static const GLshort MINLOSIZE = 8;
+    static const std::size_t MAX_QUADS = 0x10000;
+    static const GLushort MAX_PAGES = 16;
+    static const GLshort SCRATCH_SIZE = 1024;
+    static const std::uint32_t NO_SLOT = 0xFFFFFFFF;
 
+    std::unique_ptr<Backend> backend;
     bool locked;
-
-    std::vector<Quad> quads;
-    GLuint vbo;
-    GLuint atlas;
-
-    GLint program;
-    GLint attribute_coord;
-    GLint attribute_color;
-    GLint uniform_texture;
-    GLint uniform_atlas_size;
-    GLint uniform_screen_size;
-    GLint uniform_y_offset;
-    GLint uniform_font_region;
-
-    std::unordered_map<std::size_t, Offset> offsets;
+    bool core_profile;
+
+    StreamBuffer stream;
+    std::vector<Batch> batches;
+    std::vector<Command> commands;
+    //! The first quad in the stream which is not part of a command yet.
+    std::size_t run_start;
+    //! Changes whenever a bitmap used by a static batch is evicted, so that
+    //! the batches know to rebuild their vertex buffers.
+    std::uint64_t static_epoch;
+    //! Vertex buffers of released batches, deleted at the next frame.
+    std::vector<GLuint> static_garbage;
+
+    std::unordered_map<CompositeKey, Composite, CompositeHash> composites;
+    std::vector<CompositeJob> composite_jobs;
+    std::vector<AtlasHandle> composite_sources;
+    std::size_t composite_capacity;
+    CompositeStats composite_stats;
+    //! Whether draws are being captured for a composite.
+    bool capturing;
+    //! Whether every bitmap drawn since capturing started was resident.
+    bool capture_complete;
+    std::size_t capture_start;
+    std::size_t capture_sources;
+    std::int16_t capture_l;
+    std::int16_t capture_r;
+    std::int16_t capture_t;
+    std::int16_t capture_b;
+    //! Whether the backend is able to render composites.
+    bool composites_enabled;
+
+    //! The retained group being recorded, if any.
+    RetainedQuads* recording;
+    RetainedStats retained_stats;
+
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> free_slots;
+    //! The slots in use, from the least to the most recently used, linked
+    //! through the slots themselves so that a use moves a slot in constant
+    //! time.
+    std::uint32_t lru_head;
+    std::uint32_t lru_tail;
+    //! Slots of the bitmaps in the atlas, by bitmap id.
+    std::unordered_map<std::size_t, std::uint32_t> slot_ids;
     Offset null_offset;
 
-    QuadTree<std::size_t, Leftover> leftovers;
-    std::size_t rlid;
-    std::size_t wasted;
-    Point<GLshort> border;
-    Range<GLshort> y_range;
+    std::vector<Page> pages;
+    GLushort current_page;
+    //! Whether a bitmap found no room in the current frame.
+    bool atlas_full;
+    std::uint64_t frame;
+    AtlasStats atlas_stats;
+    BitmapLoader loader;
+    //! Decompressed bitmaps waiting to be uploaded.
+    std::vector<BitmapLoader::Result> uploads;
+    std::size_t upload_budget_bytes;
+    std::chrono::steady_clock::duration upload_budget;
+    UploadStats upload_stats;
 
     FT_Library ft_library;
-    Font fonts[Text::NUM_FONTS];
-    Point<GLshort> font_border;
+    std::unique_ptr<GlyphCache> glyphs;
+    LayoutBuilder layout_builder;
+    //! The height of the glyph region at the top of the first page.
     GLshort font_y_max;
 };
 
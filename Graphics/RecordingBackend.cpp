@@ -0,0 +1,115 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "RecordingBackend.h"
+
+#include "../Configuration.h"
+
+#include <algorithm>
+
+namespace jrc
+{
+GraphicsGL::RecordingBackend::RecordingBackend(StreamBuffer& s) noexcept
+    : stream{s}, core_profile{false}, next_buffer{0}
+{
+}
+
+Error GraphicsGL::RecordingBackend::init(GraphicsGL& gl,
+                                         GLushort& page_count)
+{
+    const Configuration::Video& video = Configuration::get().video;
+
+    // Follow the configuration, so that the quads and batches are the same
+    // as with the renderer that would be used.
+    core_profile = video.core_profile;
+    gl.core_profile = core_profile;
+    if (core_profile) {
+        stream.init_client(sizeof(Quad), MAX_QUADS);
+    } else {
+        stream.init_client(sizeof(Quad::Vertex) * Quad::LENGTH, MAX_QUADS);
+    }
+
+    page_count = static_cast<GLushort>(
+        std::clamp<GLint>(video.atlas_pages, 1, MAX_PAGES));
+    gl.composites_enabled = core_profile && gl.composite_capacity > 0;
+
+    return Error::NONE;
+}
+
+void GraphicsGL::RecordingBackend::reinit(GraphicsGL&)
+{
+}
+
+void GraphicsGL::RecordingBackend::upload(GLushort,
+                                          GLshort,
+                                          GLshort,
+                                          GLshort w,
+                                          GLshort h,
+                                          GLenum format,
+                                          const void*)
+{
+    std::size_t texel = format == GL_RED ? 1 : 4;
+
+    ++counters.uploads;
+    counters.upload_bytes += texel * static_cast<std::size_t>(w * h);
+}
+
+void GraphicsGL::RecordingBackend::begin_uploads()
+{
+}
+
+void GraphicsGL::RecordingBackend::upload_bitmap(const Offset&,
+                                                 const std::uint8_t*,
+                                                 std::size_t size)
+{
+    ++counters.uploads;
+    counters.upload_bytes += size;
+}
+
+void GraphicsGL::RecordingBackend::end_uploads()
+{
+}
+
+GLuint GraphicsGL::RecordingBackend::create_static(const Quad*, std::size_t)
+{
+    ++counters.static_buffers;
+    return ++next_buffer;
+}
+
+void GraphicsGL::RecordingBackend::delete_static(
+    const std::vector<GLuint>& buffers)
+{
+    counters.static_buffers -= buffers.size();
+}
+
+void GraphicsGL::RecordingBackend::flush(const Frame& frame)
+{
+    stream.commit();
+
+    ++counters.frames;
+    counters.quads += stream.size();
+    counters.draw_calls
+        += core_profile ? frame.commands.size() : frame.batches.size();
+    counters.composites += frame.composite_jobs.size();
+}
+
+const GraphicsGL::Recording*
+GraphicsGL::RecordingBackend::recording() const noexcept
+{
+    return &counters;
+}
+} // namespace jrc
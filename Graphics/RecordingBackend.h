@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "GraphicsGL.h"
+
+namespace jrc
+{
+//! A backend which only counts the work it is given, for running without a
+//! window or OpenGL context. The engine still packs the atlas and builds
+//! every frame, so the counters match what would have been sent to the GPU.
+class GraphicsGL::RecordingBackend : public GraphicsGL::Backend
+{
+public:
+    explicit RecordingBackend(StreamBuffer& s) noexcept;
+
+    Error init(GraphicsGL& gl, GLushort& page_count) override;
+    void reinit(GraphicsGL& gl) override;
+
+    void upload(GLushort page,
+                GLshort x,
+                GLshort y,
+                GLshort w,
+                GLshort h,
+                GLenum format,
+                const void* pixels) override;
+    void begin_uploads() override;
+    void upload_bitmap(const Offset& offset,
+                       const std::uint8_t* pixels,
+                       std::size_t size) override;
+    void end_uploads() override;
+
+    GLuint create_static(const Quad* quads, std::size_t count) override;
+    void delete_static(const std::vector<GLuint>& buffers) override;
+
+    void flush(const Frame& frame) override;
+
+    const Recording* recording() const noexcept override;
+
+private:
+    StreamBuffer& stream;
+    bool core_profile;
+    //! Names handed out for static batches. They only have to be non-zero
+    //! and distinct.
+    GLuint next_buffer;
+    Recording counters;
+};
+} // namespace jrc
@@ -0,0 +1,58 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../Template/Point.h"
+#include "AtlasHandle.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace jrc
+{
+//! The quads of a group of draws which rarely changes, such as a window of
+//! the user interface.
+//!
+//! The quads are recorded while the group is drawn, and then copied into
+//! the stream as they are, shifted to where the group is drawn, until the
+//! owner invalidates them. They are also recorded again if any of the
+//! bitmaps or glyphs they sample from left the atlas.
+class RetainedQuads
+{
+public:
+    //! Record the quads anew the next time the group is drawn.
+    void invalidate() noexcept;
+
+private:
+    friend class GraphicsGL;
+
+    //! The layout of a quad of `GraphicsGL`.
+    using Quad = std::array<std::uint32_t, 8>;
+
+    std::vector<Quad> quads;
+    //! The bitmaps the quads sample from, as they were when recorded.
+    std::vector<AtlasHandle> handles;
+    //! The glyph cells the quads sample from.
+    std::vector<std::uint32_t> cells;
+    //! The glyph epoch the quads were recorded in, see `GraphicsGL`.
+    std::uint64_t epoch = 0;
+    //! Where the group was drawn when the quads were recorded.
+    Point<std::int16_t> origin;
+    bool valid = false;
+};
+} // namespace jrc
@@ -0,0 +1,75 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "StaticBatch.h"
+
+#include "GraphicsGL.h"
+
+#include <utility>
+
+namespace jrc
+{
+StaticBatch::StaticBatch() noexcept : vbo{0}, epoch{0}
+{
+}
+
+StaticBatch::~StaticBatch()
+{
+    GraphicsGL::get().release_static(*this);
+}
+
+StaticBatch::StaticBatch(StaticBatch&& other) noexcept
+    : entries{std::move(other.entries)},
+      vbo{other.vbo},
+      epoch{other.epoch},
+      pages{std::move(other.pages)}
+{
+    other.entries.clear();
+    other.vbo = 0;
+    other.pages.clear();
+}
+
+StaticBatch& StaticBatch::operator=(StaticBatch&& other) noexcept
+{
+    if (this != &other) {
+        GraphicsGL::get().release_static(*this);
+
+        entries = std::move(other.entries);
+        vbo = other.vbo;
+        epoch = other.epoch;
+        pages = std::move(other.pages);
+
+        other.entries.clear();
+        other.vbo = 0;
+        other.pages.clear();
+    }
+
+    return *this;
+}
+
+void StaticBatch::add(const nl::bitmap& bitmap,
+                      const Rectangle<std::int16_t>& rect)
+{
+    GraphicsGL::get().release_static(*this);
+    entries.push_back({bitmap, {}, rect});
+}
+
+void StaticBatch::draw(Point<std::int16_t> offset) const
+{
+    GraphicsGL::get().draw_static(*this, offset);
+}
+} // namespace jrc
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../Template/Rectangle.h"
+#include "AtlasHandle.h"
+#include "GL/glew.h"
+#include "nlnx/bitmap.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace jrc
+{
+//! A group of bitmaps which never move relative to each other, such as the
+//! tiles of a map layer.
+//!
+//! With the core profile renderer, the quads are built once and kept in a
+//! vertex buffer of their own, so drawing the whole batch only costs one
+//! draw call. The buffer is rebuilt if any of the bitmaps leaves the atlas.
+//! Otherwise, the bitmaps are drawn one by one.
+class StaticBatch
+{
+public:
+    StaticBatch() noexcept;
+    ~StaticBatch();
+
+    StaticBatch(StaticBatch&& other) noexcept;
+    StaticBatch& operator=(StaticBatch&& other) noexcept;
+
+    StaticBatch(const StaticBatch&) = delete;
+    StaticBatch& operator=(const StaticBatch&) = delete;
+
+    //! Add a bitmap, drawn at the given rectangle when the batch is drawn at
+    //! the origin.
+    void add(const nl::bitmap& bitmap, const Rectangle<std::int16_t>& rect);
+    //! Draw all bitmaps, shifted by the given offset.
+    void draw(Point<std::int16_t> offset) const;
+
+private:
+    friend class GraphicsGL;
+
+    struct Entry {
+        nl::bitmap bitmap;
+        AtlasHandle handle;
+        Rectangle<std::int16_t> rect;
+    };
+
+    mutable std::vector<Entry> entries;
+    mutable GLuint vbo;
+    //! The atlas epoch the buffer was built in, see `GraphicsGL`.
+    mutable std::uint64_t epoch;
+    //! Atlas pages used by the bitmaps in the buffer.
+    mutable std::vector<GLushort> pages;
+};
+} // namespace jrc
@@ -0,0 +1,240 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "StreamBuffer.h"
+
+namespace jrc
+{
+StreamBuffer::StreamBuffer() noexcept
+    : vbo{0},
+      element_size{0},
+      capacity{0},
+      mapped{nullptr},
+      fences{},
+      region{0},
+      count{0},
+      dirty{false}
+{
+}
+
+void StreamBuffer::init(std::size_t elem_size, std::size_t cap)
+{
+    destroy();
+
+    element_size = elem_size;
+    capacity = cap;
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+
+    if (GLEW_ARB_buffer_storage) {
+        const GLbitfield flags
+            = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const auto size
+            = static_cast<GLsizeiptr>(REGIONS * capacity * element_size);
+
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        mapped = static_cast<std::uint8_t*>(
+            glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+
+        if (!mapped) {
+            // Immutable storage cannot be respecified, so start over with a
+            // fresh buffer object for the fallback path.
+            glDeleteBuffers(1, &vbo);
+            glGenBuffers(1, &vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        }
+    }
+
+    if (!mapped) {
+        staging.resize(capacity * element_size);
+        glBufferData(GL_ARRAY_BUFFER,
+                     static_cast<GLsizeiptr>(staging.size()),
+                     nullptr,
+                     GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::init_client(std::size_t elem_size, std::size_t cap)
+{
+    destroy();
+
+    element_size = elem_size;
+    capacity = cap;
+    staging.resize(capacity * element_size);
+}
+
+void StreamBuffer::destroy()
+{
+    if (vbo) {
+        for (GLsync& sync : fences) {
+            if (sync) {
+                glDeleteSync(sync);
+                sync = nullptr;
+            }
+        }
+
+        if (mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            mapped = nullptr;
+        }
+
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+
+    staging.clear();
+    staging.shrink_to_fit();
+    region = 0;
+    count = 0;
+}
+
+void StreamBuffer::begin()
+{
+    if (mapped) {
+        region = (region + 1) % REGIONS;
+
+        if (GLsync sync = fences[region]; sync) {
+            GLenum status = glClientWaitSync(sync, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED) {
+                ++stats.stalls;
+
+                do {
+                    status = glClientWaitSync(
+                        sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000);
+                } while (status == GL_TIMEOUT_EXPIRED);
+            } else {
+                ++stats.stalls_avoided;
+            }
+
+            glDeleteSync(sync);
+            fences[region] = nullptr;
+        }
+    }
+
+    count = 0;
+    dirty = true;
+
+    ++stats.frames;
+    stats.frame_bytes = 0;
+    stats.dropped = 0;
+}
+
+void* StreamBuffer::next() noexcept
+{
+    if (count >= capacity) {
+        ++stats.dropped;
+        return nullptr;
+    }
+
+    return region_data() + element_size * count++;
+}
+
+void* StreamBuffer::next(std::size_t n) noexcept
+{
+    if (count + n > capacity) {
+        stats.dropped += n;
+        return nullptr;
+    }
+
+    std::uint8_t* dest = region_data() + element_size * count;
+    count += n;
+    return dest;
+}
+
+GLint StreamBuffer::commit()
+{
+    if (dirty) {
+        const std::size_t bytes = count * element_size;
+
+        if (!mapped && vbo) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glBufferData(GL_ARRAY_BUFFER,
+                         static_cast<GLsizeiptr>(staging.size()),
+                         nullptr,
+                         GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER,
+                            0,
+                            static_cast<GLsizeiptr>(bytes),
+                            staging.data());
+        }
+
+        stats.frame_bytes = bytes;
+        stats.total_bytes += bytes;
+        dirty = false;
+    }
+
+    return mapped ? static_cast<GLint>(region * capacity) : 0;
+}
+
+void StreamBuffer::fence()
+{
+    if (!mapped) {
+        return;
+    }
+
+    if (fences[region]) {
+        glDeleteSync(fences[region]);
+    }
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamBuffer::id() const noexcept
+{
+    return vbo;
+}
+
+std::size_t StreamBuffer::size() const noexcept
+{
+    return count;
+}
+
+const std::uint8_t* StreamBuffer::data() const noexcept
+{
+    return mapped ? mapped + region * capacity * element_size
+                  : staging.data();
+}
+
+std::size_t StreamBuffer::stride() const noexcept
+{
+    return element_size;
+}
+
+bool StreamBuffer::persistent() const noexcept
+{
+    return mapped != nullptr;
+}
+
+const StreamBuffer::Stats& StreamBuffer::get_stats() const noexcept
+{
+    return stats;
+}
+
+std::uint8_t* StreamBuffer::region_data() noexcept
+{
+    if (mapped) {
+        return mapped + region * capacity * element_size;
+    } else {
+        return staging.data();
+    }
+}
+} // namespace jrc
@@ -0,0 +1,106 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "GL/glew.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jrc
+{
+//! Vertex buffer for data which is rewritten every frame.
+//!
+//! If `GL_ARB_buffer_storage` is available, the buffer is split into
+//! `REGIONS` regions which are persistently mapped and cycled through, one
+//! per frame. A fence is placed after each frame's draw call, so the CPU only
+//! ever waits for the GPU if it falls more than `REGIONS - 1` frames behind.
+//! Otherwise, the data is written to client memory and uploaded with
+//! `glBufferSubData` after orphaning the buffer.
+class StreamBuffer
+{
+public:
+    //! Counters for the current frame and for the lifetime of the buffer.
+    struct Stats {
+        std::uint64_t frames = 0;
+        std::size_t frame_bytes = 0;
+        std::uint64_t total_bytes = 0;
+        std::uint64_t stalls = 0;
+        std::uint64_t stalls_avoided = 0;
+        std::size_t dropped = 0;
+    };
+
+    static constexpr const std::size_t REGIONS = 3;
+
+    StreamBuffer() noexcept;
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    //! Create the buffer object, with room for `capacity` elements of
+    //! `element_size` bytes each per frame.
+    void init(std::size_t element_size, std::size_t capacity);
+    //! Allocate room for the elements in client memory only, without a
+    //! buffer object, for running without an OpenGL context.
+    void init_client(std::size_t element_size, std::size_t capacity);
+
+    //! Start writing a new frame, discarding the current contents.
+    void begin();
+    //! Return storage for one more element, or `nullptr` if the frame is full.
+    void* next() noexcept;
+    //! Return storage for `n` more elements, or `nullptr` if they do not all
+    //! fit.
+    void* next(std::size_t n) noexcept;
+    //! Make the contents of the current frame available to the GPU, and
+    //! return the index of its first element within the buffer.
+    GLint commit();
+    //! Mark the current region as being in use by the GPU. Must be called
+    //! after the draw call that reads it.
+    void fence();
+
+    //! Return the name of the buffer object.
+    GLuint id() const noexcept;
+    //! Return the number of elements written in the current frame.
+    std::size_t size() const noexcept;
+    //! Return the elements written in the current frame.
+    const std::uint8_t* data() const noexcept;
+    //! Return the size of an element in bytes.
+    std::size_t stride() const noexcept;
+    //! Check whether the buffer is persistently mapped.
+    bool persistent() const noexcept;
+    const Stats& get_stats() const noexcept;
+
+private:
+    void destroy();
+    std::uint8_t* region_data() noexcept;
+
+    GLuint vbo;
+    std::size_t element_size;
+    std::size_t capacity;
+
+    std::uint8_t* mapped;
+    std::vector<std::uint8_t> staging;
+    GLsync fences[REGIONS];
+    std::size_t region;
+
+    std::size_t count;
+    bool dirty;
+
+    Stats stats;
+};
+} // namespace jrc
@@ -54,6 +54,8 @@ Text::Text() noexcept : Text(A11M, LEFT, BLACK)
 
 void Text::reset_layout() noexcept
 {
+    quads.clear();
+
     if (text.empty()) {
         return;
     }
@@ -86,12 +88,18 @@ void Text::change_color(Color c)
 
 void Text::set_background(Background b)
 {
+    if (background == b) {
+        return;
+    }
+
     background = b;
+    quads.clear();
 }
 
 void Text::draw(const DrawArgument& args) const
 {
-    GraphicsGL::get().draw_text(args, text, layout, font, color, background);
+    GraphicsGL::get().draw_text(
+        args, text, layout, font, color, background, quads);
 }
 
 std::uint16_t Text::advance(std::size_t pos) const
@@ -134,13 +142,18 @@ std::string_view Text::get_text() const noexcept
     return text;
 }
 
-Text::Layout::Layout(const std::vector<Line>& l,
+void Text::QuadCache::clear() noexcept
+{
+    valid = false;
+}
+
+Text::Layout::Layout(const std::vector<Run>& r,
                      const std::vector<std::int16_t>& a,
                      std::int16_t w,
                      std::int16_t h,
                      std::int16_t ex,
                      std::int16_t ey)
-    : lines(l), advances(a), dimensions(w, h), endoffset(ex, ey)
+    : runs(r), advances(a), dimensions(w, h), endoffset(ex, ey)
 {
 }
 
@@ -176,11 +189,11 @@ Point<std::int16_t> Text::Layout::get_endoffset() const
 
 Text::Layout::iterator Text::Layout::begin() const
 {
-    return lines.begin();
+    return runs.begin();
 }
 
 Text::Layout::iterator Text::Layout::end() const
 {
-    return lines.end();
+    return runs.end();
 }
 } // namespace jrc
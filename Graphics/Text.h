@@ -18,6 +18,7 @@
 #pragma once
 #include "DrawArgument.h"
 
+#include <array>
 #include <cstdint>
 #include <map>
 #include <vector>
@@ -49,22 +50,30 @@ public:
 
     enum Background { NONE, NAMETAG };
 
+    //! Where each part of a text goes when it is drawn.
+    //!
+    //! The text is split into runs, which are drawn with a single font and
+    //! color. The runs of all lines are kept in one array, in order, and
+    //! each run knows where it starts, so drawing needs no other structure.
     class Layout
     {
     public:
-        struct Word {
-            std::size_t first;
-            std::size_t last;
+        struct Run {
+            //! The bytes of the text in the run.
+            std::uint32_t first;
+            std::uint32_t last;
+            //! The position of the first byte, relative to where the text is
+            //! drawn.
+            Point<std::int16_t> position;
+            //! The font and color of the run, or `NUM_FONTS` and
+            //! `NUM_COLORS` for those of the text.
             Font font;
             Color color;
+            //! Whether the run is the first one of its line.
+            bool line_start;
         };
 
-        struct Line {
-            std::vector<Word> words;
-            Point<std::int16_t> position;
-        };
-
-        Layout(const std::vector<Line>& lines,
+        Layout(const std::vector<Run>& runs,
                const std::vector<std::int16_t>& advances,
                std::int16_t width,
                std::int16_t height,
@@ -78,17 +87,42 @@ public:
         Point<std::int16_t> get_dimensions() const;
         Point<std::int16_t> get_endoffset() const;
 
-        using iterator = std::vector<Line>::const_iterator;
+        using iterator = std::vector<Run>::const_iterator;
         iterator begin() const;
         iterator end() const;
 
     private:
-        std::vector<Line> lines;
+        std::vector<Run> runs;
         std::vector<std::int16_t> advances;
         Point<std::int16_t> dimensions;
         Point<std::int16_t> endoffset;
     };
 
+    //! The quads of a text, relative to where it is drawn. They are built
+    //! when the text is first drawn, and copied into the stream as they are
+    //! until the text changes.
+    class QuadCache
+    {
+    public:
+        void clear() noexcept;
+
+    private:
+        friend class GraphicsGL;
+
+        //! The layout of a quad of `GraphicsGL`.
+        using Quad = std::array<std::uint32_t, 8>;
+
+        std::vector<Quad> quads;
+        //! The number of name tag quads at the front, which keep their
+        //! color whatever the text is drawn with.
+        std::size_t background_count = 0;
+        //! The glyph cells the quads sample from.
+        std::vector<std::uint32_t> cells;
+        //! The glyph epoch the quads were built in, see `GraphicsGL`.
+        std::uint64_t epoch = 0;
+        bool valid = false;
+    };
+
     Text(Font font,
          Alignment alignment,
          Color color,
@@ -130,5 +164,6 @@ private:
     std::uint16_t max_width;
     bool formatted;
     std::string text;
+    mutable QuadCache quads;
 };
 } // namespace jrc
@@ -45,7 +45,7 @@ Texture::Texture(nl::node src)
         origin = use_original_origin ? original_origin : src["origin"];
         dimensions = {bitmap.width(), bitmap.height()};
 
-        GraphicsGL::get().add_bitmap(bitmap);
+        GraphicsGL::get().add_bitmap(bitmap, handle);
     }
 }
 
@@ -66,11 +66,38 @@ void Texture::draw(const DrawArgument& args) const
     }
 
     GraphicsGL::get().draw(bitmap,
+                           handle,
                            args.get_rectangle(origin, dimensions),
                            args.get_color(),
                            args.get_angle());
 }
 
+void Texture::draw_tiled(const DrawArgument& args,
+                         Point<std::int16_t> period,
+                         Point<std::int16_t> count) const
+{
+    std::size_t id = bitmap.id();
+    if (id == 0) {
+        return;
+    }
+
+    GraphicsGL::get().draw_tiled(bitmap,
+                                 handle,
+                                 args.get_rectangle(origin, dimensions),
+                                 args.get_color(),
+                                 period,
+                                 count);
+}
+
+void Texture::add_to(StaticBatch& batch, const DrawArgument& args) const
+{
+    if (bitmap.id() == 0) {
+        return;
+    }
+
+    batch.add(bitmap, args.get_rectangle(origin, dimensions));
+}
+
 void Texture::shift(Point<std::int16_t> amount)
 {
     origin -= amount;
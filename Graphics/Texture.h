@@ -16,7 +16,9 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
+#include "AtlasHandle.h"
 #include "DrawArgument.h"
+#include "StaticBatch.h"
 #include "nlnx/bitmap.hpp"
 #include "nlnx/node.hpp"
 
@@ -32,6 +34,14 @@ public:
     ~Texture();
 
     void draw(const DrawArgument& args) const;
+    //! Draw the texture repeatedly, `count` times in each direction, with
+    //! the copies `period` pixels apart.
+    void draw_tiled(const DrawArgument& args,
+                    Point<std::int16_t> period,
+                    Point<std::int16_t> count) const;
+    //! Add the texture to a static batch, as it would be drawn with the
+    //! given arguments. Only the position and scale are used.
+    void add_to(StaticBatch& batch, const DrawArgument& args) const;
     void shift(Point<std::int16_t> amount);
 
     bool is_valid() const;
@@ -42,6 +52,8 @@ public:
 
 private:
     nl::bitmap bitmap;
+    //! Where the bitmap was last found in the atlas.
+    mutable AtlasHandle handle;
     Point<std::int16_t> origin;
     Point<std::int16_t> dimensions;
 };
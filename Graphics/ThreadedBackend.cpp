@@ -0,0 +1,340 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "ThreadedBackend.h"
+
+#include "../Util/Profiler.h"
+
+#include <cstring>
+#include <utility>
+
+namespace jrc
+{
+void GraphicsGL::ThreadedBackend::Packet::clear()
+{
+    ops.clear();
+    pixels.clear();
+    static_quads.clear();
+    quads.clear();
+    count = 0;
+    batches.clear();
+    commands.clear();
+    composite_jobs.clear();
+}
+
+GraphicsGL::ThreadedBackend::ThreadedBackend(StreamBuffer& s) noexcept
+    : stream{s},
+      inner{render_stream},
+      running{false},
+      has_pending{false},
+      stopping{false},
+      next_buffer{0}
+{
+}
+
+GraphicsGL::ThreadedBackend::~ThreadedBackend()
+{
+    stop();
+}
+
+Error GraphicsGL::ThreadedBackend::init(GraphicsGL& gl, GLushort& page_count)
+{
+    if (Error error = inner.init(gl, page_count); error) {
+        return error;
+    }
+
+    // The engine never touches the buffer the render thread draws from.
+    stream.init_client(render_stream.stride(), MAX_QUADS);
+
+    return Error::NONE;
+}
+
+void GraphicsGL::ThreadedBackend::reinit(GraphicsGL& gl)
+{
+    inner.reinit(gl);
+}
+
+void GraphicsGL::ThreadedBackend::upload(GLushort page,
+                                         GLshort x,
+                                         GLshort y,
+                                         GLshort w,
+                                         GLshort h,
+                                         GLenum format,
+                                         const void* pixels)
+{
+    if (!running) {
+        inner.upload(page, x, y, w, h, format, pixels);
+        return;
+    }
+
+    std::size_t texel = format == GL_RED ? 1 : 4;
+    std::size_t size = texel * static_cast<std::size_t>(w * h);
+    auto bytes = static_cast<const std::uint8_t*>(pixels);
+
+    back.ops.push_back({Op::UPLOAD,
+                        {x, y, w, h, page},
+                        format,
+                        0,
+                        back.pixels.size(),
+                        size});
+    back.pixels.insert(back.pixels.end(), bytes, bytes + size);
+}
+
+void GraphicsGL::ThreadedBackend::begin_uploads()
+{
+    if (!running) {
+        inner.begin_uploads();
+    }
+}
+
+void GraphicsGL::ThreadedBackend::upload_bitmap(const Offset& offset,
+                                                const std::uint8_t* pixels,
+                                                std::size_t size)
+{
+    if (!running) {
+        inner.upload_bitmap(offset, pixels, size);
+        return;
+    }
+
+    back.ops.push_back(
+        {Op::UPLOAD_BITMAP, offset, GL_BGRA, 0, back.pixels.size(), size});
+    back.pixels.insert(back.pixels.end(), pixels, pixels + size);
+}
+
+void GraphicsGL::ThreadedBackend::end_uploads()
+{
+    if (!running) {
+        inner.end_uploads();
+    }
+}
+
+GLuint GraphicsGL::ThreadedBackend::create_static(const Quad* quads,
+                                                  std::size_t count)
+{
+    GLuint name = ++next_buffer;
+    if (!running) {
+        buffers[name] = inner.create_static(quads, count);
+        return name;
+    }
+
+    back.ops.push_back(
+        {Op::CREATE_STATIC, {}, 0, name, back.static_quads.size(), count});
+    back.static_quads.insert(back.static_quads.end(), quads, quads + count);
+    return name;
+}
+
+void GraphicsGL::ThreadedBackend::delete_static(
+    const std::vector<GLuint>& names)
+{
+    if (!running) {
+        std::vector<GLuint> garbage;
+        for (GLuint name : names) {
+            if (auto iter = buffers.find(name); iter != buffers.end()) {
+                garbage.push_back(iter->second);
+                buffers.erase(iter);
+            }
+        }
+
+        inner.delete_static(garbage);
+        return;
+    }
+
+    for (GLuint name : names) {
+        back.ops.push_back({Op::DELETE_STATIC, {}, 0, name, 0, 0});
+    }
+}
+
+void GraphicsGL::ThreadedBackend::flush(const Frame& frame)
+{
+    stream.commit();
+
+    const std::uint8_t* quads = stream.data();
+    back.quads.assign(quads, quads + stream.size() * stream.stride());
+    back.count = stream.size();
+    back.batches = frame.batches;
+    back.commands = frame.commands;
+    back.composite_jobs = frame.composite_jobs;
+    back.opacity = frame.opacity;
+
+    if (!running) {
+        draw(back);
+        back.clear();
+        return;
+    }
+
+    // Normally the game waits in `wait_ready` instead, where it can give up
+    // and keep updating.
+    {
+        std::unique_lock<std::mutex> lock{mutex};
+        consumed.wait(lock, [this] { return !has_pending; });
+        std::swap(back, pending);
+        has_pending = true;
+    }
+    ready.notify_one();
+
+    back.clear();
+}
+
+bool GraphicsGL::ThreadedBackend::start(
+    std::function<void(bool)> make_current_fn,
+    std::function<void()> present_fn)
+{
+    stop();
+
+    make_current = std::move(make_current_fn);
+    present = std::move(present_fn);
+    stopping = false;
+    running = true;
+    thread = std::thread{&ThreadedBackend::run, this};
+
+    return true;
+}
+
+void GraphicsGL::ThreadedBackend::stop()
+{
+    if (!running) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    ready.notify_one();
+
+    thread.join();
+    running = false;
+}
+
+bool GraphicsGL::ThreadedBackend::wait_ready(
+    std::chrono::microseconds timeout)
+{
+    if (!running) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock{mutex};
+    return consumed.wait_for(lock, timeout, [this] { return !has_pending; });
+}
+
+void GraphicsGL::ThreadedBackend::run()
+{
+    make_current(true);
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            ready.wait(lock, [this] { return stopping || has_pending; });
+
+            // Frames which were handed over are still drawn when stopping,
+            // as their uploads have to reach the atlas.
+            if (!has_pending) {
+                break;
+            }
+
+            std::swap(front, pending);
+            has_pending = false;
+        }
+        consumed.notify_one();
+
+        {
+            Profiler::Scope scope{"ThreadedBackend::draw"};
+            draw(front);
+        }
+
+        present();
+        front.clear();
+    }
+
+    make_current(false);
+}
+
+void GraphicsGL::ThreadedBackend::draw(Packet& packet)
+{
+    std::vector<GLuint> garbage;
+    bool uploading = false;
+    for (const Op& op : packet.ops) {
+        // Bitmaps are uploaded through the pixel buffer, which must not be
+        // bound for anything else.
+        bool bitmap = op.type == Op::UPLOAD_BITMAP;
+        if (bitmap && !uploading) {
+            inner.begin_uploads();
+        } else if (!bitmap && uploading) {
+            inner.end_uploads();
+        }
+        uploading = bitmap;
+
+        const Offset& o = op.offset;
+        switch (op.type) {
+        case Op::UPLOAD:
+            inner.upload(o.page,
+                         o.l,
+                         o.t,
+                         o.r - o.l,
+                         o.b - o.t,
+                         op.format,
+                         packet.pixels.data() + op.first);
+            break;
+        case Op::UPLOAD_BITMAP:
+            inner.upload_bitmap(o, packet.pixels.data() + op.first, op.size);
+            break;
+        case Op::CREATE_STATIC:
+            buffers[op.buffer] = inner.create_static(
+                packet.static_quads.data() + op.first, op.size);
+            break;
+        case Op::DELETE_STATIC:
+            if (auto iter = buffers.find(op.buffer); iter != buffers.end()) {
+                garbage.push_back(iter->second);
+                buffers.erase(iter);
+            }
+            break;
+        }
+    }
+
+    if (uploading) {
+        inner.end_uploads();
+    }
+    if (!garbage.empty()) {
+        inner.delete_static(garbage);
+    }
+
+    for (Command& command : packet.commands) {
+        if (!command.buffer) {
+            continue;
+        }
+
+        auto iter = buffers.find(command.buffer);
+        if (iter != buffers.end()) {
+            command.buffer = iter->second;
+        } else {
+            command.count = 0;
+        }
+    }
+
+    render_stream.begin();
+    if (packet.count > 0) {
+        if (void* dest = render_stream.next(packet.count); dest) {
+            std::memcpy(dest, packet.quads.data(), packet.quads.size());
+        }
+    }
+
+    inner.flush({packet.batches,
+                 packet.commands,
+                 packet.composite_jobs,
+                 packet.opacity});
+}
+} // namespace jrc
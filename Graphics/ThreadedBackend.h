@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "GLBackend.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace jrc
+{
+//! Draws with OpenGL on a render thread of its own, so that waiting for the
+//! driver or for vsync does not hold up the game.
+//!
+//! The engine builds every frame in client memory as usual. At the end of
+//! the frame, the quads and commands are copied into a packet, together
+//! with the atlas uploads and vertex buffer changes made while building it,
+//! and handed to the render thread. Two packets are in use at a time: the
+//! one the render thread is drawing, and the one the game is filling.
+//! Until `start` is called, everything is done on the calling thread.
+class GraphicsGL::ThreadedBackend : public GraphicsGL::Backend
+{
+public:
+    explicit ThreadedBackend(StreamBuffer& s) noexcept;
+    ~ThreadedBackend() override;
+
+    Error init(GraphicsGL& gl, GLushort& page_count) override;
+    //! Must not be called while the render thread is running.
+    void reinit(GraphicsGL& gl) override;
+
+    void upload(GLushort page,
+                GLshort x,
+                GLshort y,
+                GLshort w,
+                GLshort h,
+                GLenum format,
+                const void* pixels) override;
+    void begin_uploads() override;
+    void upload_bitmap(const Offset& offset,
+                       const std::uint8_t* pixels,
+                       std::size_t size) override;
+    void end_uploads() override;
+
+    //! Vertex buffers are named by the backend, as the real ones are only
+    //! created once the render thread gets to them.
+    GLuint create_static(const Quad* quads, std::size_t count) override;
+    void delete_static(const std::vector<GLuint>& names) override;
+
+    void flush(const Frame& frame) override;
+
+    bool start(std::function<void(bool)> make_current,
+               std::function<void()> present) override;
+    void stop() override;
+    bool wait_ready(std::chrono::microseconds timeout) override;
+
+private:
+    //! A change to the atlas or to the vertex buffers, which is made before
+    //! the frame it was recorded in is drawn.
+    struct Op {
+        enum Type { UPLOAD, UPLOAD_BITMAP, CREATE_STATIC, DELETE_STATIC };
+
+        Type type;
+        //! The region of the atlas to upload to.
+        Offset offset;
+        GLenum format;
+        GLuint buffer;
+        //! The range of the pixels or static quads of the packet used.
+        std::size_t first;
+        std::size_t size;
+    };
+
+    //! Everything the render thread needs to draw a frame.
+    struct Packet {
+        std::vector<Op> ops;
+        std::vector<std::uint8_t> pixels;
+        std::vector<Quad> static_quads;
+        //! The contents of the stream.
+        std::vector<std::uint8_t> quads;
+        std::size_t count = 0;
+        std::vector<Batch> batches;
+        std::vector<Command> commands;
+        std::vector<CompositeJob> composite_jobs;
+        float opacity = 1.0f;
+
+        //! Empty the packet, keeping the memory for the next frame.
+        void clear();
+    };
+
+    //! Draw packets until told to stop.
+    void run();
+    //! Apply the changes in a packet and draw its frame. Must be called
+    //! with the context current.
+    void draw(Packet& packet);
+
+    StreamBuffer& stream;
+    //! The buffer the render thread draws from.
+    StreamBuffer render_stream;
+    GLBackend inner;
+
+    //! Whether the render thread is running. Only used by the game thread.
+    bool running;
+    std::thread thread;
+    std::function<void(bool)> make_current;
+    std::function<void()> present;
+
+    //! The packet being filled by the game thread.
+    Packet back;
+    //! The packet being drawn by the render thread.
+    Packet front;
+
+    std::mutex mutex;
+    //! Signalled when a packet is ready to be drawn, or when the render
+    //! thread should stop.
+    std::condition_variable ready;
+    //! Signalled when the render thread takes the pending packet.
+    std::condition_variable consumed;
+    Packet pending;
+    bool has_pending;
+    bool stopping;
+
+    //! The vertex buffers of static batches, by the names handed out to the
+    //! engine. Only used by the thread which draws.
+    std::unordered_map<GLuint, GLuint> buffers;
+    GLuint next_buffer;
+};
+} // namespace jrc
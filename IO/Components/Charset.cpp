@@ -41,17 +41,26 @@ Charset::Charset() noexcept : alignment(LEFT)
 
 void Charset::draw(std::int8_t c, const DrawArgument& args) const
 {
-    auto iter = chars.find(c);
-    if (iter != chars.end()) {
-        iter->second.draw(args);
+    if (const Texture* texture = get(c)) {
+        texture->draw(args);
     }
 }
 
 std::int16_t Charset::get_w(std::int8_t c) const
+{
+    const Texture* texture = get(c);
+    return texture ? texture->width() : 0;
+}
+
+const Texture* Charset::get(std::int8_t c) const
 {
     auto iter = chars.find(c);
-    return static_cast<std::int16_t>(iter != chars.end() ? iter->second.width()
-                                                         : 0);
+    return iter != chars.end() ? &iter->second : nullptr;
+}
+
+Charset::Alignment Charset::get_alignment() const noexcept
+{
+    return alignment;
 }
 
 std::int16_t Charset::draw(std::string_view text,
@@ -37,6 +37,9 @@ public:
                       std::int16_t hspace,
                       const DrawArgument& args) const;
     std::int16_t get_w(std::int8_t character) const;
+    //! Return the texture of a character, or `nullptr` if there is none.
+    const Texture* get(std::int8_t character) const;
+    Alignment get_alignment() const noexcept;
 
 private:
     std::unordered_map<std::int8_t, Texture> chars;
@@ -0,0 +1,114 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "NumberLabel.h"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+
+namespace jrc
+{
+NumberLabel::NumberLabel(const Charset& cs) : charset{cs}, formatted{false}
+{
+}
+
+NumberLabel::NumberLabel() noexcept : formatted{false}
+{
+}
+
+void NumberLabel::change(std::string_view format,
+                         std::initializer_list<std::int64_t> values)
+{
+    if (formatted
+        && std::equal(
+               values.begin(), values.end(), numbers.begin(), numbers.end())) {
+        return;
+    }
+
+    numbers.assign(values);
+    formatted = true;
+
+    std::array<char, CAPACITY> buffer;
+    char* out = buffer.data();
+    char* const end = buffer.data() + buffer.size();
+    auto value = values.begin();
+    for (std::size_t i = 0; i < format.size() && out != end; ++i) {
+        if (value != values.end() && format.compare(i, 2, "{}") == 0) {
+            // On overflow, the result points at the end of the buffer.
+            out = std::to_chars(out, end, *value++).ptr;
+            i += 1;
+        } else if (value != values.end()
+                   && format.compare(i, 4, "{.2}") == 0) {
+            std::int64_t hundredths = *value++;
+            out = std::to_chars(out, end, hundredths / 100).ptr;
+            if (end - out >= 3) {
+                auto fraction = static_cast<char>(std::abs(hundredths % 100));
+                *out++ = '.';
+                *out++ = static_cast<char>('0' + fraction / 10);
+                *out++ = static_cast<char>('0' + fraction % 10);
+            }
+            i += 3;
+        } else {
+            *out++ = format[i];
+        }
+    }
+
+    layout({buffer.data(), static_cast<std::size_t>(out - buffer.data())});
+}
+
+void NumberLabel::layout(std::string_view line)
+{
+    glyphs.clear();
+
+    // The same alignment rules as `Charset::draw`.
+    std::int16_t shift = 0;
+    switch (charset.get_alignment()) {
+    case Charset::CENTER:
+        for (char c : line) {
+            shift += charset.get_w(c);
+        }
+        shift = static_cast<std::int16_t>(-shift / 2);
+        [[fallthrough]];
+    case Charset::LEFT:
+        for (char c : line) {
+            if (const Texture* texture = charset.get(c)) {
+                glyphs.push_back({*texture, shift});
+                shift += texture->width();
+            }
+        }
+        break;
+    case Charset::RIGHT:
+        for (auto iter = line.rbegin(); iter != line.rend(); ++iter) {
+            if (const Texture* texture = charset.get(*iter)) {
+                shift += texture->width();
+                glyphs.push_back(
+                    {*texture, static_cast<std::int16_t>(-shift)});
+            }
+        }
+        break;
+    }
+}
+
+void NumberLabel::draw(const DrawArgument& args) const
+{
+    for (const Glyph& glyph : glyphs) {
+        glyph.texture.draw(args + Point<std::int16_t>{glyph.x, 0});
+    }
+}
+} // namespace jrc
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "Charset.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string_view>
+#include <vector>
+
+namespace jrc
+{
+//! A line of numbers drawn with a charset, such as the stats on the status
+//! bar.
+//!
+//! The line is only formatted again when one of its numbers changes. The
+//! textures of its characters and where they go are kept until then, so
+//! drawing an unchanged line formats nothing and looks nothing up.
+class NumberLabel
+{
+public:
+    //! The most characters a line can have.
+    static constexpr const std::size_t CAPACITY = 64;
+
+    NumberLabel(const Charset& charset);
+    NumberLabel() noexcept;
+
+    //! Show the numbers in the given format. Every `{}` in the format is
+    //! replaced with the next number, and every `{.2}` with the next number
+    //! divided by a hundred, with two decimals. The format is expected to
+    //! stay the same from one call to the next.
+    void change(std::string_view format,
+                std::initializer_list<std::int64_t> numbers);
+    void draw(const DrawArgument& args) const;
+
+private:
+    //! Find the texture and position of every character of the line.
+    void layout(std::string_view line);
+
+    struct Glyph {
+        Texture texture;
+        //! The horizontal offset from where the line is drawn.
+        std::int16_t x;
+    };
+
+    Charset charset;
+    std::vector<std::int64_t> numbers;
+    std::vector<Glyph> glyphs;
+    bool formatted;
+};
+} // namespace jrc
@@ -0,0 +1,171 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "ProfilerOverlay.h"
+
+#include "../../Constants.h"
+#include "../../Graphics/GraphicsGL.h"
+#include "../../Util/Profiler.h"
+#include "../../Util/Str.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace jrc
+{
+namespace
+{
+constexpr std::int16_t LEFT = 4;
+constexpr std::int16_t TOP = 4 - Constants::VIEW_Y_OFFSET;
+constexpr std::int16_t GRAPH_HEIGHT = 64;
+constexpr std::int16_t LINE_HEIGHT = 14;
+//! The frame time at the top of the graph, in nanoseconds.
+constexpr std::int64_t GRAPH_SCALE = 33'333'333;
+constexpr std::int64_t TARGET_FRAME = GRAPH_SCALE / 2;
+
+std::string milliseconds(std::int64_t nanoseconds)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof buf, "%.2f ms", nanoseconds / 1'000'000.0);
+
+    return buf;
+}
+} // namespace
+
+ProfilerOverlay::ProfilerOverlay() : countdown{0}, replayed{0}, rebuilt{0}
+{
+    lines.resize(TOP_COUNT + 2, Text{Text::A11M, Text::LEFT, Text::WHITE});
+}
+
+void ProfilerOverlay::draw() const
+{
+    auto& graphics = GraphicsGL::get();
+    auto width = static_cast<std::int16_t>(Profiler::HISTORY);
+    auto height = static_cast<std::int16_t>(
+        GRAPH_HEIGHT + LINE_HEIGHT * static_cast<std::int16_t>(lines.size())
+        + 8);
+    graphics.draw_rectangle(LEFT - 2,
+                            TOP - 2,
+                            std::max<std::int16_t>(width, 320) + 4,
+                            height,
+                            0.0f,
+                            0.0f,
+                            0.0f,
+                            0.6f);
+
+    // One bar per frame, green when it met the target, yellow when it took
+    // up to twice as long and red after that.
+    std::vector<std::int64_t> times = Profiler::get().frame_times();
+    auto x = static_cast<std::int16_t>(LEFT + width
+                                       - static_cast<std::int16_t>(
+                                           times.size()));
+    for (std::int64_t time : times) {
+        auto bar = static_cast<std::int16_t>(
+            std::min(time, GRAPH_SCALE) * GRAPH_HEIGHT / GRAPH_SCALE);
+        float red = time > TARGET_FRAME ? 1.0f : 0.0f;
+        float green = time > GRAPH_SCALE ? 0.0f : 1.0f;
+        graphics.draw_rectangle(x,
+                                TOP + GRAPH_HEIGHT - bar,
+                                1,
+                                std::max<std::int16_t>(bar, 1),
+                                red,
+                                green,
+                                0.0f,
+                                0.8f);
+        ++x;
+    }
+
+    graphics.draw_rectangle(
+        LEFT, TOP + GRAPH_HEIGHT / 2, width, 1, 1.0f, 1.0f, 1.0f, 0.5f);
+
+    auto y = static_cast<std::int16_t>(TOP + GRAPH_HEIGHT + 4);
+    for (const Text& line : lines) {
+        line.draw(Point<std::int16_t>{LEFT, y});
+        y += LINE_HEIGHT;
+    }
+}
+
+void ProfilerOverlay::update()
+{
+    if (countdown > 0) {
+        --countdown;
+        return;
+    }
+
+    countdown = REFRESH;
+
+    auto& profiler = Profiler::get();
+    std::vector<std::int64_t> times = profiler.frame_times();
+    if (times.empty()) {
+        return;
+    }
+
+    std::int64_t total = 0;
+    std::int64_t worst = 0;
+    for (std::int64_t time : times) {
+        total += time;
+        worst = std::max(worst, time);
+    }
+
+    lines[0].change_text(
+        str::concat("Frame: ",
+                    milliseconds(total / static_cast<std::int64_t>(
+                                             times.size())),
+                    ", worst ",
+                    milliseconds(worst)));
+
+    std::vector<Profiler::Summary> scopes = profiler.top_scopes(TOP_COUNT);
+    for (std::size_t i = 0; i < TOP_COUNT; ++i) {
+        if (i >= scopes.size()) {
+            lines[i + 1].change_text("");
+            continue;
+        }
+
+        const Profiler::Summary& scope = scopes[i];
+        std::string name = scope.name;
+        if (scope.arg >= 0) {
+            name = str::concat(
+                name, ' ', str::to_hex(static_cast<std::uint32_t>(scope.arg)));
+        }
+
+        lines[i + 1].change_text(str::concat(name,
+                                             ": ",
+                                             milliseconds(scope.average),
+                                             ", worst ",
+                                             milliseconds(scope.worst),
+                                             ", ",
+                                             std::to_string(scope.calls),
+                                             " calls"));
+    }
+
+    const GraphicsGL::RetainedStats& retained
+        = GraphicsGL::get().get_retained_stats();
+    std::uint64_t new_replayed = retained.replayed - replayed;
+    std::uint64_t new_rebuilt = retained.rebuilt - rebuilt;
+    replayed = retained.replayed;
+    rebuilt = retained.rebuilt;
+
+    std::uint64_t ui_quads = new_replayed + new_rebuilt;
+    lines[TOP_COUNT + 1].change_text(
+        ui_quads ? str::concat("UI quads: ",
+                               std::to_string(new_replayed * 100 / ui_quads),
+                               "% replayed, ",
+                               std::to_string(new_rebuilt),
+                               " rebuilt")
+                 : "UI quads: none");
+}
+} // namespace jrc
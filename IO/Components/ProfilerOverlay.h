@@ -0,0 +1,48 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../../Graphics/Text.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace jrc
+{
+//! Shows the frame times and the most expensive scopes recorded by the
+//! `Profiler`, in the top left corner of the screen, along with how many of
+//! the quads of retained UI elements were replayed rather than rebuilt.
+class ProfilerOverlay
+{
+public:
+    ProfilerOverlay();
+
+    void draw() const;
+    void update();
+
+private:
+    //! Refresh the text this often, in updates.
+    static constexpr const std::uint16_t REFRESH = 60;
+    static constexpr const std::size_t TOP_COUNT = 8;
+
+    std::vector<Text> lines;
+    std::uint16_t countdown;
+    //! The retained quad counters at the last refresh.
+    std::uint64_t replayed;
+    std::uint64_t rebuilt;
+};
+} // namespace jrc
@@ -18,6 +18,7 @@
 #include "UI.h"
 
 #include "../Graphics/GraphicsGL.h"
+#include "../Util/Profiler.h"
 #include "UIStateGame.h"
 #include "UIStateLogin.h"
 #include "UITypes/UIChangeChannel.h"
@@ -37,17 +38,29 @@ void UI::init()
 
 void UI::draw(float alpha) const
 {
+    Profiler::Scope scope{"UI::draw"};
+
     state->draw(alpha, cursor.get_position());
 
     scrolling_notice.draw(alpha);
+    if (Profiler::get().overlay_enabled()) {
+        profiler_overlay.draw();
+    }
+
     cursor.draw(alpha);
 }
 
 void UI::update()
 {
+    Profiler::Scope scope{"UI::update"};
+
     state->update();
 
     scrolling_notice.update();
+    if (Profiler::get().overlay_enabled()) {
+        profiler_overlay.update();
+    }
+
     cursor.update();
 }
 
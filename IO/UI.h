@@ -19,6 +19,7 @@
 #include "../Template/Singleton.h"
 #include "../Template/nullable_ptr.h"
 #include "Components/Icon.h"
+#include "Components/ProfilerOverlay.h"
 #include "Components/ScrollingNotice.h"
 #include "Components/Textfield.h"
 #include "Cursor.h"
@@ -84,6 +85,7 @@ private:
     Keyboard keyboard;
     Cursor cursor;
     ScrollingNotice scrolling_notice;
+    ProfilerOverlay profiler_overlay;
 
     nullable_ptr<Textfield> focused_text_field;
     std::unordered_map<std::int32_t, bool> is_key_down;
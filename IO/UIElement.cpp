@@ -19,11 +19,12 @@
 
 #include "../Audio/Audio.h"
 #include "../Constants.h"
+#include "../Graphics/GraphicsGL.h"
 
 namespace jrc
 {
 UIElement::UIElement(Point<std::int16_t> p, Point<std::int16_t> d, bool a)
-    : position(p), dimension(d), active(a)
+    : position(p), dimension(d), active(a), retained(false)
 {
 }
 
@@ -42,6 +43,28 @@ void UIElement::draw(float alpha) const
     draw_buttons(alpha);
 }
 
+void UIElement::render(float alpha) const
+{
+    if (!retained) {
+        draw(alpha);
+        return;
+    }
+
+    auto& graphics = GraphicsGL::get();
+    if (graphics.draw_retained(quads, position)) {
+        return;
+    }
+
+    graphics.begin_retained(quads);
+    draw(alpha);
+    graphics.end_retained(quads, position);
+}
+
+void UIElement::invalidate() const noexcept
+{
+    quads.invalidate();
+}
+
 void UIElement::draw_sprites(float alpha) const
 {
     for (const Sprite& sprite : sprites) {
@@ -16,6 +16,7 @@
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
+#include "../Graphics/RetainedQuads.h"
 #include "../Graphics/Sprite.h"
 #include "Components/Button.h"
 #include "Components/Icon.h"
@@ -66,6 +67,13 @@ public:
     virtual void draw(float inter) const;
     virtual void update();
 
+    //! Draw the element. Retained elements replay the quads of their last
+    //! draw instead, unless they were invalidated since.
+    void render(float inter) const;
+    //! Make a retained element draw itself again the next time it is
+    //! rendered, because it changed.
+    void invalidate() const noexcept;
+
     void make_active() noexcept;
     void deactivate() noexcept;
     bool is_active() const noexcept;
@@ -95,5 +103,12 @@ protected:
     Point<std::int16_t> position;
     Point<std::int16_t> dimension;
     bool active;
+    //! Whether the element only looks different after it is invalidated,
+    //! so that it can be rendered from its last draw. Animations and hover
+    //! effects need it to be invalidated every frame they change.
+    bool retained;
+
+private:
+    mutable RetainedQuads quads;
 };
 } // namespace jrc
@@ -37,7 +37,9 @@
 namespace jrc
 {
 UIStateGame::UIStateGame()
-    : focused(UIElement::NONE), tooltip_parent(Tooltip::NONE)
+    : focused(UIElement::NONE),
+      hovered(UIElement::NONE),
+      tooltip_parent(Tooltip::NONE)
 {
     const CharLook& look = Stage::get().get_player().get_look();
     const CharStats& stats = Stage::get().get_player().get_stats();
@@ -55,7 +57,7 @@ void UIStateGame::draw(float inter, Point<std::int16_t> cursor) const
     for (const auto& type : element_order) {
         auto& element = elements[type];
         if (element && element->is_active()) {
-            element->draw(inter);
+            element->render(inter);
         }
     }
 
@@ -87,9 +89,19 @@ void UIStateGame::drop_icon(const Icon& icon, Point<std::int16_t> pos)
     }
 }
 
+void UIStateGame::invalidate_all()
+{
+    for (const auto& type : element_order) {
+        if (auto& element = elements[type]) {
+            element->invalidate();
+        }
+    }
+}
+
 void UIStateGame::double_click(Point<std::int16_t> pos)
 {
     if (UIElement* front = get_front(pos)) {
+        front->invalidate();
         front->double_click(pos);
     }
 }
@@ -148,6 +160,8 @@ Cursor::State UIStateGame::send_cursor(Cursor::State mst,
             drop_icon(*dragged_icon, pos);
             dragged_icon->reset();
             dragged_icon = {};
+            // The icon goes back to its slot, in whichever element that is.
+            invalidate_all();
             return mst;
         default:
             return Cursor::GRABBING;
@@ -156,6 +170,7 @@ Cursor::State UIStateGame::send_cursor(Cursor::State mst,
         bool clicked = mst == Cursor::CLICKING;
         if (UIElement* focused_element = get(focused); focused_element) {
             if (focused_element->is_active()) {
+                focused_element->invalidate();
                 return focused_element->send_cursor(clicked, pos);
             } else {
                 focused = UIElement::NONE;
@@ -168,6 +183,12 @@ Cursor::State UIStateGame::send_cursor(Cursor::State mst,
             for (const auto& type : element_order) {
                 auto& element = elements[type];
                 if (element && element->is_active()) {
+                    // Holding the button down may still drag something,
+                    // such as a slider, after the cursor left the element.
+                    if (clicked) {
+                        element->invalidate();
+                    }
+
                     bool found = element->is_in_range(pos)
                                      ? true
                                      : element->remove_cursor(clicked, pos);
@@ -186,7 +207,19 @@ Cursor::State UIStateGame::send_cursor(Cursor::State mst,
                 clear_tooltip(tooltip_parent);
             }
 
+            // Hover effects change in the element the cursor is over, and
+            // in the one it just left.
+            if (hovered != front_type) {
+                if (UIElement* previous = get(hovered)) {
+                    previous->invalidate();
+                }
+
+                hovered = front_type;
+            }
+
             if (front) {
+                front->invalidate();
+
                 if (clicked) {
                     element_order.erase(
                         std::remove_if(
@@ -275,6 +308,7 @@ UIStateGame::pre_add(UIElement::Type type, bool is_toggled, bool is_focused)
             element_order.end());
         element_order.push_back(type);
         element->toggle_active();
+        element->invalidate();
         return elements.end();
     } else {
         remove(type);
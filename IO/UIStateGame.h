@@ -60,12 +60,17 @@ public:
 
 private:
     void drop_icon(const Icon& icon, Point<std::int16_t> pos);
+    //! Make every element draw itself again, after a change which may show
+    //! in any of them.
+    void invalidate_all();
     template<class T, typename... Args>
     void emplace(Args&&... args);
 
     EnumMap<UIElement::Type, UIElement::UPtr, UIElement::NUM_TYPES> elements;
     std::vector<UIElement::Type> element_order;
     UIElement::Type focused;
+    //! The element which received the cursor last.
+    UIElement::Type hovered;
 
     EquipTooltip eq_tooltip;
     ItemTooltip it_tooltip;
@@ -17,6 +17,7 @@
 //////////////////////////////////////////////////////////////////////////////
 #include "UIChatBar.h"
 
+#include "../../Graphics/GraphicsGL.h"
 #include "../../Net/Packets/MessagingPackets.h"
 #include "../Components/MapleButton.h"
 #include "../UI.h"
@@ -33,7 +34,12 @@ UIChatbar::UIChatbar(Point<std::int16_t> pos)
     chat_rows = 4;
     row_pos = 0;
     row_max = -1;
+    warmed_pos = -1;
+    warmed_rows = 0;
     lastpos = 0;
+    first_line = 0;
+    last_serial = 0;
+    lines.reserve(MAXLINES);
 
     nl::node mainbar = nl::nx::ui["StatusBar2.img"]["mainBar"];
     nl::node chat_target_src = mainbar["chatTarget"];
@@ -108,6 +114,7 @@ UIChatbar::UIChatbar(Point<std::int16_t> pos)
                   std::int16_t next = up ? row_pos - 1 : row_pos + 1;
                   if (next >= 0 && next <= row_max) {
                       row_pos = next;
+                      lay_out_view(false);
                   }
               }};
 }
@@ -126,18 +133,17 @@ void UIChatbar::draw(float inter) const
         std::int16_t chatheight = CHAT_ROW_HEIGHT * chat_rows;
         std::int16_t yshift = -chatheight;
         for (std::int16_t i = 0; i < chat_rows; ++i) {
-            std::int16_t rowid = row_pos - i;
-            if (!row_texts.count(rowid)) {
+            const Text* text = find_row(row_pos - i);
+            if (!text) {
                 break;
             }
 
-            std::int16_t textheight
-                = row_texts.at(rowid).height() / CHAT_ROW_HEIGHT;
+            std::int16_t textheight = text->height() / CHAT_ROW_HEIGHT;
             while (textheight > 0) {
                 yshift += CHAT_ROW_HEIGHT;
                 --textheight;
             }
-            row_texts.at(rowid).draw({4, get_chat_top() - yshift - 1});
+            text->draw({4, get_chat_top() - yshift - 1});
         }
 
         slider.draw({position.x(), get_chat_top() + 5});
@@ -145,8 +151,8 @@ void UIChatbar::draw(float inter) const
         chattargets[chattarget].draw(position + Point<std::int16_t>(0, 2));
         chatcover.draw(position);
         chat_field.draw(position);
-    } else if (row_texts.count(row_max)) {
-        row_texts.at(row_max).draw(position + Point<std::int16_t>(-500, -60));
+    } else if (const Text* text = find_row(row_max)) {
+        text->draw(position + Point<std::int16_t>(-500, -60));
     }
 }
 
@@ -155,6 +161,14 @@ void UIChatbar::update()
     UIElement::update();
 
     chat_field.update(position);
+
+    // Glyphs of lines scrolled back into view may have been evicted from
+    // the atlas since, so they are rasterised here rather than while
+    // drawing.
+    bool moved = warmed_pos != row_pos || warmed_rows != chat_rows;
+    warmed_pos = row_pos;
+    warmed_rows = chat_rows;
+    lay_out_view(moved);
 }
 
 Button::State UIChatbar::button_pressed(std::uint16_t id)
@@ -166,6 +180,7 @@ Button::State UIChatbar::button_pressed(std::uint16_t id)
         buttons[BT_CLOSECHAT]->set_active(true);
         buttons[BT_CHATTARGETS]->set_active(true);
         chat_field.set_state(Textfield::NORMAL);
+        lay_out_view(false);
         break;
     case BT_CLOSECHAT:
         chatopen = false;
@@ -173,6 +188,7 @@ Button::State UIChatbar::button_pressed(std::uint16_t id)
         buttons[BT_CLOSECHAT]->set_active(false);
         buttons[BT_CHATTARGETS]->set_active(false);
         chat_field.set_state(Textfield::DISABLED);
+        lay_out_view(false);
         break;
     }
 
@@ -233,6 +249,7 @@ Cursor::State UIChatbar::send_cursor(bool clicking,
             chat_box.setheight(1 + chat_rows * CHAT_ROW_HEIGHT);
             slider.set_rows(row_pos, chat_rows, row_max);
             slider.set_vertical({0, CHAT_ROW_HEIGHT * chat_rows - 14});
+            lay_out_view(false);
             return Cursor::CLICKING;
         } else {
             drag_chat_top = false;
@@ -249,35 +266,88 @@ Cursor::State UIChatbar::send_cursor(bool clicking,
     return UIElement::send_cursor(clicking, cursorpos);
 }
 
-void UIChatbar::send_line(std::string&& line, LineType type)
+void UIChatbar::send_line(std::string&& text, LineType type)
 {
-    ++row_max;
+    Text::Color color;
+    switch (type) {
+    case RED:
+        color = Text::DARKRED;
+        break;
+    case BLUE:
+        color = Text::MEDIUMBLUE;
+        break;
+    case YELLOW:
+        color = Text::YELLOW;
+        break;
+    default:
+        color = Text::WHITE;
+        break;
+    }
+
+    Line line{std::move(text), color, ++last_serial};
+    if (lines.size() < MAXLINES) {
+        lines.push_back(std::move(line));
+    } else {
+        lines[first_line] = std::move(line);
+        first_line = (first_line + 1) % lines.size();
+    }
+
+    row_max = static_cast<std::int16_t>(lines.size() - 1);
     row_pos = row_max;
 
     slider.set_rows(row_pos, chat_rows, row_max);
 
-    row_texts.emplace(std::piecewise_construct,
-                      std::forward_as_tuple(row_max),
-                      std::forward_as_tuple(Text::A12M,
-                                            Text::LEFT,
-                                            [](auto type) {
-                                                switch (type) {
-                                                case RED:
-                                                    return Text::DARKRED;
-                                                case BLUE:
-                                                    return Text::MEDIUMBLUE;
-                                                case YELLOW:
-                                                    return Text::YELLOW;
-                                                default:
-                                                    return Text::WHITE;
-                                                }
-                                            }(type),
-                                            std::move(line),
-                                            480));
+    // Lines can arrive after the update, and jump the view back to the
+    // newest line, so the view is laid out before it is drawn.
+    lay_out_view(false);
 }
 
 std::int16_t UIChatbar::get_chat_top() const
 {
     return position.y() - chat_rows * CHAT_ROW_HEIGHT - CHAT_Y_OFFSET;
 }
+
+const UIChatbar::Line& UIChatbar::get_line(std::int16_t row) const
+{
+    return lines[(first_line + static_cast<std::size_t>(row)) % lines.size()];
+}
+
+const Text* UIChatbar::find_row(std::int16_t row) const
+{
+    if (row < 0 || row > row_max) {
+        return nullptr;
+    }
+
+    std::uint64_t serial = get_line(row).serial;
+    const Row& laid_out = rows[serial % MAXCHATROWS];
+    return laid_out.serial == serial ? &laid_out.text : nullptr;
+}
+
+bool UIChatbar::lay_out(std::int16_t row)
+{
+    const Line& line = get_line(row);
+    Row& laid_out = rows[line.serial % MAXCHATROWS];
+    if (laid_out.serial == line.serial) {
+        return false;
+    }
+
+    laid_out.text = {
+        Text::A12M, Text::LEFT, line.color, std::string{line.text}, 480};
+    laid_out.serial = line.serial;
+    return true;
+}
+
+void UIChatbar::lay_out_view(bool warm)
+{
+    // Only the lines in view are laid out, in the rows of lines which
+    // scrolled out of it.
+    std::int16_t last = chatopen ? row_pos : row_max;
+    std::int16_t count = chatopen ? chat_rows : 1;
+    for (std::int16_t i = 0; i < count && last - i >= 0; ++i) {
+        if (lay_out(last - i) || warm) {
+            GraphicsGL::get().warm_glyphs(get_line(last - i).text,
+                                          Text::A12M);
+        }
+    }
+}
 } // namespace jrc
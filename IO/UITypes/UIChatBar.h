@@ -17,12 +17,15 @@
 //////////////////////////////////////////////////////////////////////////////
 #pragma once
 #include "../../Graphics/Geometry.h"
+#include "../../Graphics/Text.h"
 #include "../../Graphics/Texture.h"
 #include "../Components/Slider.h"
 #include "../Components/Textfield.h"
 #include "../UIElement.h"
 
-#include <unordered_map>
+#include <array>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 namespace jrc
@@ -58,7 +61,33 @@ protected:
     Button::State button_pressed(std::uint16_t buttonid) override;
 
 private:
+    //! A line of the chat log, kept as text until it is shown.
+    struct Line {
+        std::string text;
+        Text::Color color;
+        //! Counts up from one with every line ever received.
+        std::uint64_t serial;
+    };
+
+    //! A laid out line. Rows are reused as lines scroll in and out of view.
+    struct Row {
+        Text text;
+        //! The serial of the line in the row, or zero for none.
+        std::uint64_t serial = 0;
+    };
+
     std::int16_t get_chat_top() const;
+    //! Return the line at the given row, counting from the oldest line.
+    const Line& get_line(std::int16_t row) const;
+    //! Return the laid out text of a row, or `nullptr` if it has not been
+    //! laid out yet.
+    const Text* find_row(std::int16_t row) const;
+    //! Lay out the line at a row, unless it already is. Returns whether it
+    //! was laid out now.
+    bool lay_out(std::int16_t row);
+    //! Lay out the lines in view, and rasterise the glyphs of those laid
+    //! out now. With `warm` set, the glyphs of all of them are rasterised.
+    void lay_out_view(bool warm);
 
     enum Buttons : std::uint16_t {
         BT_OPENCHAT,
@@ -72,6 +101,8 @@ private:
     static constexpr const std::int16_t CHAT_ROW_HEIGHT = 16;
     static constexpr const std::int16_t MAXCHATROWS = 16;
     static constexpr const std::int16_t MINCHATROWS = 1;
+    //! The most lines kept. Older lines are dropped.
+    static constexpr const std::int16_t MAXLINES = 500;
 
     Textfield chat_field;
     Texture chatspace[2];
@@ -87,11 +118,20 @@ private:
     std::vector<std::string> last_entered;
     std::size_t lastpos;
 
-    std::unordered_map<std::int16_t, Text> row_texts;
+    //! A ring of the last `MAXLINES` lines, starting at `first_line`.
+    std::vector<Line> lines;
+    std::size_t first_line;
+    std::uint64_t last_serial;
+    //! The lines in view, each in the row given by its serial modulo
+    //! `MAXCHATROWS`.
+    std::array<Row, MAXCHATROWS> rows;
     ColorBox chat_box;
     std::int16_t chat_rows;
     std::int16_t row_pos;
     std::int16_t row_max;
+    //! The view whose glyphs were last rasterised ahead of drawing.
+    std::int16_t warmed_pos;
+    std::int16_t warmed_rows;
     Slider slider;
     bool drag_chat_top;
 };
@@ -96,6 +96,7 @@ UIItemInventory::UIItemInventory(const Inventory& invent)
               }};
 
     dimension = {172, 335};
+    retained = true;
     active = true;
 
     load_icons();
@@ -138,11 +139,17 @@ void UIItemInventory::update()
 
     new_item_tab.update(6);
     new_item_slot.update(6);
+    if (new_tab != InventoryType::NONE) {
+        invalidate();
+    }
 
     std::int64_t meso = inventory.get_meso();
     std::string meso_str = std::to_string(meso);
     string_format::split_number(meso_str);
-    meso_label.change_text(std::move(meso_str));
+    if (meso_str != meso_label.get_text()) {
+        meso_label.change_text(std::move(meso_str));
+        invalidate();
+    }
 }
 
 void UIItemInventory::update_slot(std::int16_t slot)
@@ -305,6 +312,8 @@ void UIItemInventory::modify(InventoryType::Id type,
         return;
     }
 
+    invalidate();
+
     if (type == tab) {
         switch (mode) {
         case Inventory::ADD:
@@ -349,6 +358,8 @@ void UIItemInventory::modify(InventoryType::Id type,
 
 void UIItemInventory::enable_sort()
 {
+    invalidate();
+
     buttons[BT_GATHER]->set_active(false);
     buttons[BT_SORT]->set_active(true);
     buttons[BT_SORT]->set_state(Button::NORMAL);
@@ -356,6 +367,8 @@ void UIItemInventory::enable_sort()
 
 void UIItemInventory::enable_gather()
 {
+    invalidate();
+
     buttons[BT_SORT]->set_active(false);
     buttons[BT_GATHER]->set_active(true);
     buttons[BT_GATHER]->set_state(Button::NORMAL);
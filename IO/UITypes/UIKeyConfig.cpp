@@ -199,6 +199,7 @@ UIKeyConfig::UIKeyConfig()
         std::make_unique<KeyIcon>(KeyAction::Id::FACE_7), icon_data[106], -1);
 
     dimension = {622, 374};
+    retained = true;
     reload_mappings();
     active = true;
 }
@@ -386,6 +387,8 @@ void UIKeyConfig::reset_to_default() noexcept
 
 void UIKeyConfig::clear_mappings() noexcept
 {
+    invalidate();
+
     std::uint8_t first_empty = 0;
     for (auto [_, action_id] : slot_mappings.left) {
         if (!KeyAction::is_key_action(action_id)) {
@@ -429,6 +432,8 @@ bool UIKeyConfig::commit_mappings() noexcept
 
 void UIKeyConfig::clear() noexcept
 {
+    invalidate();
+
     slot_mappings.left.clear();
     palette_slots.left.clear();
 }
@@ -447,6 +452,8 @@ void UIKeyConfig::refresh_palette() noexcept
 
 void UIKeyConfig::adjust_mapping(Slot slot, std::int32_t action) noexcept
 {
+    invalidate();
+
     auto [from_slot, from_type] = dragged_from;
     auto [to_slot, to_type] = slot;
 
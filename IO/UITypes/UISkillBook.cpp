@@ -175,6 +175,7 @@ UISkillbook::UISkillbook(const CharStats& in_stats,
     change_sp(stats.get_stat(Maplestat::SP));
 
     dimension = {174, 299};
+    retained = true;
 }
 
 void UISkillbook::draw(float alpha) const
@@ -311,6 +312,8 @@ Cursor::State UISkillbook::send_cursor(bool clicked,
 
 void UISkillbook::update_stat(Maplestat::Id stat, std::int16_t value)
 {
+    invalidate();
+
     switch (stat) {
     case Maplestat::JOB:
         change_job(value);
@@ -325,6 +328,8 @@ void UISkillbook::update_stat(Maplestat::Id stat, std::int16_t value)
 
 void UISkillbook::update_skills(std::int32_t skill_id)
 {
+    invalidate();
+
     if (skill_id / 10'000 == job.get_id()) {
         change_tab(tab);
     }
@@ -99,6 +99,7 @@ UIStatsinfo::UIStatsinfo(const CharStats& st)
     update_stat(Maplestat::FAME);
 
     dimension = {212, 318};
+    retained = true;
     showdetail = false;
 }
 
@@ -127,6 +128,8 @@ void UIStatsinfo::draw(float alpha) const
 
 void UIStatsinfo::update_all_stats()
 {
+    invalidate();
+
     update_simple(AP, Maplestat::AP);
     if (hasap ^ (stats.get_stat(Maplestat::AP) > 0)) {
         update_ap();
@@ -197,6 +200,8 @@ void UIStatsinfo::update_all_stats()
 
 void UIStatsinfo::update_stat(Maplestat::Id stat)
 {
+    invalidate();
+
     switch (stat) {
     case Maplestat::JOB:
         statlabels[JOB].change_text(std::string(stats.get_job_name()));
@@ -24,8 +24,6 @@
 #include "UISystemSettings.h"
 #include "nlnx/nx.hpp"
 
-#include <string_view>
-
 namespace jrc
 {
 constexpr Point<std::int16_t> UIStatusbar::POSITION;
@@ -51,8 +49,12 @@ UIStatusbar::UIStatusbar(const CharStats& st)
     auto mp_bar_src = gauge_src["mp"];
     mpbar = {mp_bar_src["0"], mp_bar_src["1"], mp_bar_src["2"], 137, 0.0f};
 
-    statset = {gauge_src["number"], Charset::RIGHT};
-    levelset = {mainbar["lvNumber"], Charset::LEFT};
+    Charset statset{gauge_src["number"], Charset::RIGHT};
+    explabel = {statset};
+    hplabel = {statset};
+    mplabel = {statset};
+    levellabel = {Charset{mainbar["lvNumber"], Charset::LEFT}};
+    update_labels();
 
     joblabel = {Text::A11M, Text::LEFT, Text::YELLOW};
     namelabel = {Text::A13M, Text::LEFT, Text::WHITE};
@@ -91,29 +93,10 @@ void UIStatusbar::draw(float alpha) const
     hpbar.draw(position + Point<std::int16_t>{-261, -31});
     mpbar.draw(position + Point<std::int16_t>{-90, -31});
 
-    std::int16_t level = stats.get_stat(Maplestat::LEVEL);
-    std::int16_t hp = stats.get_stat(Maplestat::HP);
-    std::int16_t mp = stats.get_stat(Maplestat::MP);
-    std::int32_t max_hp = stats.get_total(Equipstat::HP);
-    std::int32_t max_mp = stats.get_total(Equipstat::MP);
-    std::int64_t exp = stats.get_exp();
-
-    std::string exp_string = std::to_string(100.0f * get_exp_percent());
-    statset.draw(
-        str::concat(
-            std::to_string(exp),
-            '[',
-            std::string_view(exp_string).substr(0, exp_string.find('.') + 3),
-            "%]"),
-        position + Point<std::int16_t>{47, -13});
-    statset.draw(
-        str::concat('[', std::to_string(hp), '/', std::to_string(max_hp), ']'),
-        position + Point<std::int16_t>{-124, -29});
-    statset.draw(
-        str::concat('[', std::to_string(mp), '/', std::to_string(max_mp), ']'),
-        position + Point<std::int16_t>{47, -29});
-    levelset.draw(std::to_string(level),
-                  position + Point<std::int16_t>{-480, -24});
+    explabel.draw(position + Point<std::int16_t>{47, -13});
+    hplabel.draw(position + Point<std::int16_t>{-124, -29});
+    mplabel.draw(position + Point<std::int16_t>{47, -29});
+    levellabel.draw(position + Point<std::int16_t>{-480, -24});
 
     joblabel.draw(position + Point<std::int16_t>{-435, -21});
     namelabel.draw(position + Point<std::int16_t>{-435, -36});
@@ -131,6 +114,8 @@ void UIStatusbar::update()
     hpbar.update(get_hp_percent());
     mpbar.update(get_mp_percent());
 
+    update_labels();
+
     namelabel.change_text(std::string{stats.get_name()});
     joblabel.change_text(std::string{stats.get_job_name()});
 
@@ -139,6 +124,21 @@ void UIStatusbar::update()
     }
 }
 
+void UIStatusbar::update_labels()
+{
+    // The percentage is cut off after two decimals, not rounded.
+    auto exp_hundredths
+        = static_cast<std::int64_t>(10'000.0f * get_exp_percent());
+    explabel.change("{}[{.2}%]", {stats.get_exp(), exp_hundredths});
+    hplabel.change("[{}/{}]",
+                   {stats.get_stat(Maplestat::HP),
+                    stats.get_total(Equipstat::HP)});
+    mplabel.change("[{}/{}]",
+                   {stats.get_stat(Maplestat::MP),
+                    stats.get_total(Equipstat::MP)});
+    levellabel.change("{}", {stats.get_stat(Maplestat::LEVEL)});
+}
+
 Button::State UIStatusbar::button_pressed(std::uint16_t id)
 {
     switch (id) {
@@ -21,8 +21,8 @@
 #include "../../Character/Job.h"
 #include "../../Graphics/Animation.h"
 #include "../../Graphics/Text.h"
-#include "../Components/Charset.h"
 #include "../Components/Gauge.h"
+#include "../Components/NumberLabel.h"
 #include "../Components/Textfield.h"
 #include "../Messages.h"
 #include "../UIElement.h"
@@ -54,6 +54,8 @@ protected:
     Button::State button_pressed(std::uint16_t buttonid) override;
 
 private:
+    //! Show the current stats on the number labels.
+    void update_labels();
     float get_exp_percent() const;
     float get_hp_percent() const;
     float get_mp_percent() const;
@@ -91,8 +93,10 @@ private:
     Gauge expbar;
     Gauge hpbar;
     Gauge mpbar;
-    Charset statset;
-    Charset levelset;
+    NumberLabel explabel;
+    NumberLabel hplabel;
+    NumberLabel mplabel;
+    NumberLabel levellabel;
     Text namelabel;
     Text joblabel;
     Animation hpanimation;
@@ -22,8 +22,11 @@
 #include "../Constants.h"
 #include "../Graphics/GraphicsGL.h"
 #include "../Util/Misc.h"
+#include "../Util/Profiler.h"
 #include "UI.h"
 
+#include <chrono>
+#include <string>
 #include <string_view>
 
 namespace jrc
@@ -31,6 +34,8 @@ namespace jrc
 Window::Window()
     : glwnd{nullptr},
       context{nullptr},
+      headless{false},
+      threaded{false},
       opacity{1.0f},
       opcstep{0.0f},
       width{Constants::VIEW_WIDTH},
@@ -43,16 +48,47 @@ Window::~Window()
     glfwTerminate();
 }
 
-Error Window::init()
+Error Window::init(bool without_window)
 {
     full_screen = Configuration::get().video.fullscreen;
 
+    headless = without_window;
+    if (headless) {
+        if (Error error = GraphicsGL::get().init(true)) {
+            return error;
+        }
+
+        GraphicsGL::get().reinit();
+        return Error::NONE;
+    }
+
     if (!glfwInit()) {
         return Error::GLFW;
     }
 
     glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
-    context = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+    if (Configuration::get().video.core_profile) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+        context = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+        if (!context) {
+            Console::get().print("[Warning] Could not create an OpenGL 3.3 "
+                                 "core profile context, falling back to the "
+                                 "legacy renderer.");
+
+            glfwDefaultWindowHints();
+            glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+        }
+    }
+
+    if (!context) {
+        context = glfwCreateWindow(1, 1, "", nullptr, nullptr);
+    }
     glfwMakeContextCurrent(context);
     glfwSetErrorCallback([](int no, const char* description) noexcept {
         Console::get().print(str::concat("GLFW error: ",
@@ -64,7 +100,7 @@ Error Window::init()
     glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
     glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
 
-    if (Error error = GraphicsGL::get().init()) {
+    if (Error error = GraphicsGL::get().init(false)) {
         return error;
     }
 
@@ -73,6 +109,8 @@ Error Window::init()
 
 Error Window::init_window()
 {
+    stop_rendering();
+
     if (glwnd) {
         glfwDestroyWindow(glwnd);
     }
@@ -92,14 +130,24 @@ Error Window::init_window()
     glfwSwapInterval(Configuration::get().video.vsync ? 1 : 0);
 
     glViewport(0, 0, Constants::VIEW_WIDTH, Constants::VIEW_HEIGHT);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
 
     glfwSetInputMode(glwnd, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
     // glfwSetInputMode(glwnd, GLFW_STICKY_KEYS, 1);
-    glfwSetKeyCallback(glwnd, [](GLFWwindow*, int key, int, int action, int) {
-        UI::get().send_key(key, action != GLFW_RELEASE);
-    });
+    glfwSetKeyCallback(
+        glwnd, [](GLFWwindow*, int key, int, int action, int mods) {
+            // Ctrl + F9 and Ctrl + F10 are kept for the profiler, as the
+            // function keys themselves can be mapped to anything in game.
+            if ((mods & GLFW_MOD_CONTROL)
+                && (key == GLFW_KEY_F9 || key == GLFW_KEY_F10)) {
+                if (action == GLFW_PRESS) {
+                    Window::get().profiler_key(key);
+                }
+
+                return;
+            }
+
+            UI::get().send_key(key, action != GLFW_RELEASE);
+        });
     glfwSetMouseButtonCallback(glwnd,
                                [](GLFWwindow*, int button, int action, int) {
                                    switch (button) {
@@ -135,12 +183,49 @@ Error Window::init_window()
 
     GraphicsGL::get().reinit();
 
+    start_rendering();
+
     return Error::NONE;
 }
 
+void Window::stop_rendering()
+{
+    if (threaded) {
+        GraphicsGL::get().stop_rendering();
+        glfwMakeContextCurrent(glwnd);
+        threaded = false;
+    }
+}
+
+void Window::start_rendering()
+{
+    if (headless) {
+        return;
+    }
+
+    // Only the context moves to the render thread. Windows are still
+    // created, and events polled, on this thread, as GLFW requires.
+    glfwMakeContextCurrent(nullptr);
+    threaded = GraphicsGL::get().start_rendering(
+        [this](bool current) {
+            glfwMakeContextCurrent(current ? glwnd : nullptr);
+        },
+        [this]() { glfwSwapBuffers(glwnd); });
+    if (!threaded) {
+        glfwMakeContextCurrent(glwnd);
+    }
+}
+
 bool Window::not_closed() const
 {
-    return glfwWindowShouldClose(glwnd) == 0;
+    return headless || glfwWindowShouldClose(glwnd) == 0;
+}
+
+bool Window::is_focused() const
+{
+    return headless
+           || (glfwGetWindowAttrib(glwnd, GLFW_FOCUSED)
+               && !glfwGetWindowAttrib(glwnd, GLFW_ICONIFIED));
 }
 
 void Window::update()
@@ -165,8 +250,33 @@ void Window::update_opc()
     }
 }
 
+void Window::profiler_key(std::int32_t key) const
+{
+    if (key == GLFW_KEY_F9) {
+        Profiler::get().toggle_overlay();
+        return;
+    }
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    std::string path = str::concat(
+        "trace-",
+        std::to_string(
+            std::chrono::duration_cast<std::chrono::seconds>(now).count()),
+        ".json");
+    if (Profiler::get().dump_trace(path)) {
+        Console::get().print(str::concat("Wrote profiler trace to ", path));
+    } else {
+        Console::get().print(
+            str::concat("Could not write profiler trace to ", path));
+    }
+}
+
 void Window::check_events()
 {
+    if (headless) {
+        return;
+    }
+
     std::int32_t tabstate = glfwGetKey(glwnd, GLFW_KEY_F11);
     if (tabstate == GLFW_PRESS) {
         full_screen = !full_screen;
@@ -183,7 +293,9 @@ void Window::begin() const
 void Window::end() const
 {
     GraphicsGL::get().flush(opacity);
-    glfwSwapBuffers(glwnd);
+    if (!headless && !threaded) {
+        glfwSwapBuffers(glwnd);
+    }
 }
 
 void Window::fadeout(float step, std::function<void()> fade_proc)
@@ -194,21 +306,30 @@ void Window::fadeout(float step, std::function<void()> fade_proc)
 
 void Window::set_clipboard(const char* text) const
 {
-    glfwSetClipboardString(glwnd, text);
+    if (!headless) {
+        glfwSetClipboardString(glwnd, text);
+    }
 }
 void Window::set_clipboard(const std::string& text) const
 {
-    glfwSetClipboardString(glwnd, text.c_str());
+    set_clipboard(text.c_str());
 }
 
 const char* Window::get_clipboard() const
 {
+    if (headless) {
+        return "";
+    }
+
     const char* text = glfwGetClipboardString(glwnd);
     return text ? text : "";
 }
 
 void Window::resize(bool in_game) noexcept
 {
+    // The render thread reads the size when drawing composites.
+    stop_rendering();
+
     if (in_game) {
         width = Constants::GAME_VIEW_WIDTH;
         height = Constants::GAME_VIEW_HEIGHT;
@@ -217,14 +338,18 @@ void Window::resize(bool in_game) noexcept
         height = Constants::VIEW_HEIGHT;
     }
 
-    glfwSetWindowSize(glwnd, width, height);
-    glViewport(0, 0, width, height);
+    if (!headless) {
+        glfwSetWindowSize(glwnd, width, height);
+        glViewport(0, 0, width, height);
+    }
     GraphicsGL::set_screen(0,
                            width,
                            -Constants::VIEW_Y_OFFSET,
                            -Constants::VIEW_Y_OFFSET + height);
 
     GraphicsGL::get().reinit();
+
+    start_rendering();
 }
 
 std::int16_t Window::get_width() const noexcept
@@ -32,10 +32,15 @@ public:
     Window();
     ~Window() override;
 
-    Error init();
+    //! Create the window and initialise the graphics engine. If
+    //! without_window is set, nothing is shown and no OpenGL context is
+    //! created.
+    Error init(bool without_window);
     Error init_window();
 
     bool not_closed() const;
+    //! Check whether the window is focused, and not minimised.
+    bool is_focused() const;
     void update();
     void begin() const;
     void end() const;
@@ -52,9 +57,18 @@ public:
 
 private:
     void update_opc();
+    //! Stop the render thread, and take the context back.
+    void stop_rendering();
+    //! Hand the context to the render thread, if there is one.
+    void start_rendering();
+    //! Toggle the profiler overlay on F9, or dump a trace on F10.
+    void profiler_key(std::int32_t key) const;
 
     GLFWwindow* glwnd;
     GLFWwindow* context;
+    bool headless;
+    //! Whether frames are drawn and presented by a render thread.
+    bool threaded;
     bool full_screen;
     float opacity;
     float opcstep;
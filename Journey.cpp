@@ -20,19 +20,26 @@
 #include "Configuration.h"
 #include "Constants.h"
 #include "Error.h"
+#include "FramePacer.h"
 #include "Gameplay/Combat/DamageNumber.h"
 #include "Gameplay/Stage.h"
+#include "Graphics/GraphicsGL.h"
 #include "IO/UI.h"
 #include "IO/Window.h"
 #include "Net/Session.h"
 #include "Timer.h"
+#include "Util/HitchDetector.h"
 #include "Util/NxFiles.h"
+#include "Util/Profiler.h"
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <string_view>
 
 namespace jrc
 {
-Error init()
+Error init(bool headless)
 {
     if (Error error = Session::get().init(); error) {
         return error;
@@ -42,7 +49,7 @@ Error init()
         return error;
     }
 
-    if (Error error = Window::get().init(); error) {
+    if (Error error = Window::get().init(headless); error) {
         return error;
     }
 
@@ -94,8 +101,11 @@ bool running()
 void loop()
 {
     Timer::get().start();
+    FramePacer::get().start();
+    Profiler::get().start();
     std::int64_t timestep = Constants::TIMESTEP * 1'000;
     std::int64_t accumulator = timestep;
+    const std::int64_t max_accumulator = timestep * Constants::MAX_CATCHUP;
 
     std::int64_t period = 0;
     std::int32_t samples = 0;
@@ -103,15 +113,30 @@ void loop()
     while (running()) {
         std::int64_t elapsed = Timer::get().stop();
 
-        // Update game with constant timestep as many times as possible.
-        for (accumulator += elapsed; accumulator >= timestep;
-             accumulator -= timestep) {
+        // Update game with constant timestep as many times as possible. Time
+        // beyond what can be caught up with is dropped, as running even more
+        // updates would only make the next frame later still.
+        accumulator = std::min(accumulator + elapsed, max_accumulator);
+        for (; accumulator >= timestep; accumulator -= timestep) {
             update();
         }
 
-        // Draw the game. Interpolate to account for remaining time.
+        // Draw the game. Interpolate to account for remaining time. If the
+        // render thread is still busy with the last frame, wait for it only
+        // until the next update is due, and skip drawing this time around.
         float alpha = static_cast<float>(accumulator) / timestep;
-        draw(alpha);
+        std::chrono::microseconds until_update{timestep - accumulator};
+        if (GraphicsGL::get().wait_ready(until_update)) {
+            draw(alpha);
+        }
+
+        const Configuration::Video& video = Configuration::get().video;
+        FramePacer::get().set_rate(Window::get().is_focused()
+                                       ? video.max_fps
+                                       : video.background_fps);
+        Profiler::get().end_frame(FramePacer::get().wait());
+        HitchDetector::get().check(Profiler::get().last_frame(),
+                                   Stage::get().get_map_id());
 
         if (samples < 100) {
             period += elapsed;
@@ -125,17 +150,29 @@ void loop()
         }
     }
 
+    GraphicsGL::get().close();
     Sound::close();
+
+    if (const auto* recording = GraphicsGL::get().get_recording()) {
+        std::cout << "Frames: " << recording->frames
+                  << "\nDraw calls: " << recording->draw_calls
+                  << "\nQuads: " << recording->quads
+                  << "\nUploads: " << recording->uploads << " ("
+                  << recording->upload_bytes << " bytes)"
+                  << "\nComposites rendered: " << recording->composites
+                  << '\n'
+                  << std::flush;
+    }
 }
 
-void start()
+void start(bool headless)
 {
     // Unsynchronize `std::cout`/`std::cin`/etc. with C stdio for performance
     // reasons.
     std::ios::sync_with_stdio(false);
 
     // Initialize and check for errors.
-    if (Error error = init()) {
+    if (Error error = init(headless)) {
         const char* message = error.get_message();
         const char* args = error.get_args();
         const bool can_retry = error.can_retry();
@@ -146,7 +183,7 @@ void start()
         std::cin >> command;
 
         if (can_retry && command == "retry") {
-            start();
+            start(headless);
         }
     } else {
         loop();
@@ -154,8 +191,17 @@ void start()
 }
 } // namespace jrc
 
-int main()
+int main(int argc, char** argv)
 {
-    jrc::start();
+    // Without a window, the client still logs in and runs the game, which
+    // is useful for profiling everything but the GPU.
+    bool headless = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view{argv[i]} == "--headless") {
+            headless = true;
+        }
+    }
+
+    jrc::start(headless);
     return 0;
 }
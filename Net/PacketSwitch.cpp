@@ -18,6 +18,7 @@
 #include "PacketSwitch.h"
 
 #include "../Console.h"
+#include "../Util/Profiler.h"
 #include "Handlers/AttackHandlers.h"
 #include "Handlers/CommonHandlers.h"
 #include "Handlers/InventoryHandlers.h"
@@ -232,6 +233,7 @@ void PacketSwitch::forward(const std::int8_t* bytes, std::size_t length) const
     InPacket recv{bytes, length};
     // Read the opcode to determine handler responsible.
     auto opcode = static_cast<std::uint16_t>(recv.read_short());
+    Profiler::Scope scope{"PacketSwitch::forward", opcode};
 
     if (opcode < NUM_HANDLERS) {
         if (auto& handler = handlers[opcode]) {
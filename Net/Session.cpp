@@ -18,6 +18,7 @@
 #include "Session.h"
 
 #include "../Configuration.h"
+#include "../Util/Profiler.h"
 
 namespace jrc
 {
@@ -139,6 +140,8 @@ bool Session::write(std::int8_t* packet_bytes,
 
 void Session::read()
 {
+    Profiler::Scope scope{"Session::read"};
+
     // Check if a packet has arrived. Handle if data is sufficient:
     //     4 bytes(header) + 2 bytes(opcode) = 6.
     std::size_t result = socket.receive(&connected);
@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "Rectangle.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace jrc
+{
+//! A spatial index which divides an area into square cells of equal size.
+//! Every item is stored in each cell its bounds overlap, so items can be
+//! found by area without testing all of them.
+class UniformGrid
+{
+public:
+    explicit UniformGrid(std::int16_t size = 256) : cell_size{size}
+    {
+    }
+
+    //! Add an item with the given bounds. The index is what queries return.
+    void insert(std::uint32_t index, const Rectangle<std::int16_t>& bounds)
+    {
+        items.push_back({index, bounds});
+    }
+
+    //! Sort the items into cells. Must be called after the last insertion
+    //! and before the first query.
+    void build()
+    {
+        cells.clear();
+        if (items.empty()) {
+            columns = 0;
+            rows = 0;
+            return;
+        }
+
+        left = items.front().bounds.l();
+        top = items.front().bounds.t();
+        right = left;
+        bottom = top;
+        for (const Item& item : items) {
+            const Rectangle<std::int16_t>& b = item.bounds;
+            left = std::min<std::int32_t>({left, b.l(), b.r()});
+            top = std::min<std::int32_t>({top, b.t(), b.b()});
+            right = std::max<std::int32_t>({right, b.l(), b.r()});
+            bottom = std::max<std::int32_t>({bottom, b.t(), b.b()});
+        }
+
+        columns = (right - left) / cell_size + 1;
+        rows = (bottom - top) / cell_size + 1;
+        cells.resize(static_cast<std::size_t>(columns * rows));
+
+        for (const Item& item : items) {
+            Span span = get_span(item.bounds);
+            for (std::int32_t y = span.top; y <= span.bottom; ++y) {
+                for (std::int32_t x = span.left; x <= span.right; ++x) {
+                    cells[y * columns + x].push_back(item.index);
+                }
+            }
+        }
+
+        items.clear();
+        items.shrink_to_fit();
+    }
+
+    //! Return the indices of all items in cells which overlap the area, in
+    //! ascending order and without duplicates. The result is only valid
+    //! until the next query.
+    const std::vector<std::uint32_t>&
+    query(const Rectangle<std::int16_t>& area) const
+    {
+        found.clear();
+        if (cells.empty()
+            || std::max(area.l(), area.r()) < left
+            || std::min(area.l(), area.r()) > right
+            || std::max(area.t(), area.b()) < top
+            || std::min(area.t(), area.b()) > bottom) {
+            return found;
+        }
+
+        Span span = get_span(area);
+        for (std::int32_t y = span.top; y <= span.bottom; ++y) {
+            for (std::int32_t x = span.left; x <= span.right; ++x) {
+                const std::vector<std::uint32_t>& cell
+                    = cells[y * columns + x];
+                found.insert(found.end(), cell.begin(), cell.end());
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        return found;
+    }
+
+private:
+    struct Item {
+        std::uint32_t index;
+        Rectangle<std::int16_t> bounds;
+    };
+
+    //! A range of cells, clamped to the grid.
+    struct Span {
+        std::int32_t left;
+        std::int32_t right;
+        std::int32_t top;
+        std::int32_t bottom;
+    };
+
+    Span get_span(const Rectangle<std::int16_t>& area) const
+    {
+        auto column = [&](std::int32_t x) {
+            return std::clamp((x - left) / cell_size, 0, columns - 1);
+        };
+        auto row = [&](std::int32_t y) {
+            return std::clamp((y - top) / cell_size, 0, rows - 1);
+        };
+
+        return {column(std::min(area.l(), area.r())),
+                column(std::max(area.l(), area.r())),
+                row(std::min(area.t(), area.b())),
+                row(std::max(area.t(), area.b()))};
+    }
+
+    std::int32_t cell_size;
+    std::int32_t left = 0;
+    std::int32_t top = 0;
+    std::int32_t right = 0;
+    std::int32_t bottom = 0;
+    std::int32_t columns = 0;
+    std::int32_t rows = 0;
+
+    std::vector<Item> items;
+    std::vector<std::vector<std::uint32_t>> cells;
+    mutable std::vector<std::uint32_t> found;
+};
+} // namespace jrc
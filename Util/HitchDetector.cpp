@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "HitchDetector.h"
+
+#include "../Configuration.h"
+#include "Str.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace jrc
+{
+namespace
+{
+std::string milliseconds(std::int64_t nanoseconds)
+{
+    char buf[16];
+    std::snprintf(buf, sizeof buf, "%.2fms", nanoseconds / 1'000'000.0);
+
+    return buf;
+}
+
+struct Culprit {
+    const char* name;
+    std::int32_t arg;
+    std::int64_t total;
+    std::uint32_t calls;
+};
+} // namespace
+
+HitchDetector::HitchDetector() noexcept : log_size{0}
+{
+}
+
+void HitchDetector::check(const Profiler::Frame& frame, std::int32_t map_id)
+{
+    // Time spent waiting for the frame rate limit is not a hitch. Without
+    // leaving it out, every frame of a window in the background, limited to
+    // 30 frames per second, would be logged.
+    std::uint16_t threshold = Configuration::get().video.hitch_threshold_ms;
+    std::int64_t busy = frame.duration - frame.idle;
+    if (threshold == 0 || busy <= threshold * 1'000'000ll) {
+        return;
+    }
+
+    // Sum up the time of each scope, so that a hundred mobs spawning at
+    // once show up as one culprit. Nested scopes are listed along with
+    // their parents, which makes the innermost slow scope the one to blame.
+    std::vector<Culprit> culprits;
+    for (const Profiler::Event& event : frame.events) {
+        auto iter = std::find_if(
+            culprits.begin(), culprits.end(), [&](const Culprit& c) {
+                return c.name == event.name && c.arg == event.arg;
+            });
+        if (iter == culprits.end()) {
+            culprits.push_back({event.name, event.arg, 0, 0});
+            iter = culprits.end() - 1;
+        }
+
+        iter->total += event.duration;
+        ++iter->calls;
+    }
+
+    culprits.erase(std::remove_if(culprits.begin(),
+                                  culprits.end(),
+                                  [](const Culprit& c) {
+                                      return c.total < MIN_SCOPE;
+                                  }),
+                   culprits.end());
+    std::sort(culprits.begin(),
+              culprits.end(),
+              [](const Culprit& a, const Culprit& b) {
+                  return a.total > b.total;
+              });
+    culprits.resize(std::min(culprits.size(), MAX_SCOPES));
+
+    char time_buf[24];
+    std::time_t now = std::time(nullptr);
+    std::strftime(
+        time_buf, sizeof time_buf, "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+
+    std::string line
+        = str::concat(std::string_view{time_buf},
+                      " frame ",
+                      milliseconds(busy),
+                      " map ",
+                      map_id >= 0 ? std::to_string(map_id) : std::string{"-"});
+    for (const Culprit& culprit : culprits) {
+        line += " | ";
+        line += culprit.name;
+        if (culprit.arg >= 0) {
+            line += ' ';
+            line += str::to_hex(static_cast<std::uint32_t>(culprit.arg));
+        }
+
+        line += ' ';
+        line += milliseconds(culprit.total);
+        if (culprit.calls > 1) {
+            line += " x";
+            line += std::to_string(culprit.calls);
+        }
+    }
+
+    write(line);
+}
+
+void HitchDetector::write(const std::string& line)
+{
+    if (log.is_open() && log_size + line.size() + 1 > MAX_LOG_SIZE) {
+        log.close();
+        std::remove(OLD_LOG_PATH);
+        std::rename(LOG_PATH, OLD_LOG_PATH);
+    }
+
+    if (!log.is_open()) {
+        log.open(LOG_PATH, std::ios::app | std::ios::ate);
+        if (!log) {
+            return;
+        }
+
+        log_size = static_cast<std::size_t>(log.tellp());
+    }
+
+    // Flushed right away, so that the line survives if the hitch turns out
+    // to be the start of a crash.
+    log << line << std::endl;
+    log_size += line.size() + 1;
+}
+} // namespace jrc
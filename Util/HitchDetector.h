@@ -0,0 +1,57 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../Template/Singleton.h"
+#include "Profiler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+
+namespace jrc
+{
+//! Watches for frames which take longer than the configured threshold, not
+//! counting time spent waiting for the frame rate limit, and writes the
+//! scopes which ran long in them to a log file.
+//!
+//! Each slow frame becomes a single line, with the time, the map, and the
+//! slowest scopes, e.g. `Mob::Mob 12.40ms x30`. The log is rolled over once
+//! it reaches `MAX_LOG_SIZE`, keeping one older log next to it.
+class HitchDetector : public Singleton<HitchDetector>
+{
+public:
+    HitchDetector() noexcept;
+
+    //! Check the frame which has just finished. `map_id` is the map that was
+    //! loaded at the end of it, or -1.
+    void check(const Profiler::Frame& frame, std::int32_t map_id);
+
+private:
+    //! Scopes which are shorter than this are left out, in nanoseconds.
+    static constexpr const std::int64_t MIN_SCOPE = 1'000'000;
+    static constexpr const std::size_t MAX_SCOPES = 8;
+    static constexpr const std::size_t MAX_LOG_SIZE = 256 * 1024;
+    static constexpr const char* LOG_PATH = "hitches.log";
+    static constexpr const char* OLD_LOG_PATH = "hitches.log.1";
+
+    void write(const std::string& line);
+
+    std::ofstream log;
+    std::size_t log_size;
+};
+} // namespace jrc
@@ -0,0 +1,247 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#include "Profiler.h"
+
+#include "Str.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace jrc
+{
+Profiler::Profiler() noexcept
+    : epoch{clock::now()},
+      frame_start{epoch},
+      next_thread{1},
+      dropped{0},
+      frames(HISTORY),
+      current{0},
+      frame_count{0},
+      overlay{false}
+{
+}
+
+void Profiler::start() noexcept
+{
+    frame_start = clock::now();
+}
+
+Profiler::RingOwner::~RingOwner()
+{
+    if (ring) {
+        ring->owned.store(false, std::memory_order_release);
+    }
+}
+
+void Profiler::record(const char* name,
+                      std::int32_t arg,
+                      clock::time_point start,
+                      clock::time_point end) noexcept
+{
+    Ring& ring = thread_ring();
+
+    std::size_t head = ring.head.load(std::memory_order_relaxed);
+    std::size_t tail = ring.tail.load(std::memory_order_acquire);
+    if (head - tail >= RING_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring.events[head % RING_SIZE] = {name,
+                                     arg,
+                                     ring.thread,
+                                     since_start(start),
+                                     nanoseconds(end - start)};
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::end_frame(clock::duration idle)
+{
+    auto now = clock::now();
+
+    Frame& frame = frames[current];
+    {
+        std::lock_guard<std::mutex> lock{ring_mutex};
+        for (auto& ring : rings) {
+            std::size_t tail = ring->tail.load(std::memory_order_relaxed);
+            std::size_t head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail) {
+                frame.events.push_back(ring->events[tail % RING_SIZE]);
+            }
+
+            ring->tail.store(tail, std::memory_order_release);
+        }
+    }
+
+    frame.start = since_start(frame_start);
+    frame.duration = nanoseconds(now - frame_start);
+    frame.idle = std::min(nanoseconds(idle), frame.duration);
+    frame_start = now;
+
+    current = (current + 1) % HISTORY;
+    frames[current].events.clear();
+    frame_count = std::min(frame_count + 1, HISTORY - 1);
+}
+
+const Profiler::Frame& Profiler::last_frame() const noexcept
+{
+    return frames[(current + HISTORY - 1) % HISTORY];
+}
+
+std::vector<std::int64_t> Profiler::frame_times() const
+{
+    std::vector<std::int64_t> times;
+    times.reserve(frame_count);
+
+    std::size_t first = current + HISTORY - frame_count;
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        times.push_back(frames[(first + i) % HISTORY].duration);
+    }
+
+    return times;
+}
+
+std::vector<Profiler::Summary> Profiler::top_scopes(std::size_t count) const
+{
+    if (frame_count == 0) {
+        return {};
+    }
+
+    // There are only a few dozen distinct scopes, so a linear search is
+    // cheaper than hashing here.
+    std::vector<Summary> scopes;
+    std::size_t first = current + HISTORY - frame_count;
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        for (const Event& event : frames[(first + i) % HISTORY].events) {
+            auto iter = std::find_if(
+                scopes.begin(), scopes.end(), [&](const Summary& s) {
+                    return s.name == event.name && s.arg == event.arg;
+                });
+            if (iter == scopes.end()) {
+                scopes.push_back({event.name, event.arg, 0, 0, 0});
+                iter = scopes.end() - 1;
+            }
+
+            iter->average += event.duration;
+            iter->worst = std::max(iter->worst, event.duration);
+            ++iter->calls;
+        }
+    }
+
+    for (Summary& scope : scopes) {
+        scope.average /= static_cast<std::int64_t>(frame_count);
+    }
+
+    count = std::min(count, scopes.size());
+    std::partial_sort(scopes.begin(),
+                      scopes.begin() + count,
+                      scopes.end(),
+                      [](const Summary& a, const Summary& b) {
+                          return a.average > b.average;
+                      });
+    scopes.resize(count);
+
+    return scopes;
+}
+
+bool Profiler::dump_trace(const std::string& path) const
+{
+    std::ofstream file{path};
+    if (!file) {
+        return false;
+    }
+
+    // Timestamps are in microseconds.
+    file << std::fixed;
+    file.precision(3);
+    file << "{\"traceEvents\":[";
+
+    bool first_event = true;
+    std::size_t first = current + HISTORY - frame_count;
+    for (std::size_t i = 0; i < frame_count; ++i) {
+        const Frame& frame = frames[(first + i) % HISTORY];
+
+        file << (first_event ? "\n" : ",\n")
+             << "{\"name\":\"Frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":"
+             << frame.start / 1000.0 << ",\"dur\":" << frame.duration / 1000.0
+             << '}';
+        first_event = false;
+
+        for (const Event& event : frame.events) {
+            file << ",\n{\"name\":\"" << event.name;
+            if (event.arg >= 0) {
+                file << ' '
+                     << str::to_hex(static_cast<std::uint32_t>(event.arg));
+            }
+
+            file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                 << ",\"ts\":" << event.start / 1000.0
+                 << ",\"dur\":" << event.duration / 1000.0 << '}';
+        }
+    }
+
+    file << "\n],\"otherData\":{\"dropped\":"
+         << dropped.load(std::memory_order_relaxed) << "}}\n";
+
+    return static_cast<bool>(file);
+}
+
+void Profiler::toggle_overlay() noexcept
+{
+    overlay = !overlay;
+}
+
+bool Profiler::overlay_enabled() const noexcept
+{
+    return overlay;
+}
+
+Profiler::Ring& Profiler::thread_ring()
+{
+    thread_local RingOwner owner;
+    if (owner.ring) {
+        return *owner.ring;
+    }
+
+    std::lock_guard<std::mutex> lock{ring_mutex};
+    auto iter = std::find_if(rings.begin(), rings.end(), [](const auto& r) {
+        return !r->owned.load(std::memory_order_acquire);
+    });
+    if (iter == rings.end()) {
+        rings.push_back(std::make_unique<Ring>());
+        iter = rings.end() - 1;
+    }
+
+    owner.ring = iter->get();
+    owner.ring->owned.store(true, std::memory_order_relaxed);
+    owner.ring->thread = next_thread++;
+
+    return *owner.ring;
+}
+
+std::int64_t Profiler::since_start(clock::time_point time) const noexcept
+{
+    return nanoseconds(time - epoch);
+}
+
+std::int64_t Profiler::nanoseconds(clock::duration duration) noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration)
+        .count();
+}
+} // namespace jrc
@@ -0,0 +1,179 @@
+//////////////////////////////////////////////////////////////////////////////
+// This file is part of the LibreMaple MMORPG client                        //
+// Copyright © 2018-2019 LibreMaple Team                                    //
+//                                                                          //
+// This program is free software: you can redistribute it and/or modify     //
+// it under the terms of the GNU Affero General Public License as           //
+// published by the Free Software Foundation, either version 3 of the       //
+// License, or (at your option) any later version.                          //
+//                                                                          //
+// This program is distributed in the hope that it will be useful,          //
+// but WITHOUT ANY WARRANTY; without even the implied warranty of           //
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the            //
+// GNU Affero General Public License for more details.                      //
+//                                                                          //
+// You should have received a copy of the GNU Affero General Public License //
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.    //
+//////////////////////////////////////////////////////////////////////////////
+#pragma once
+#include "../Template/Singleton.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jrc
+{
+//! Records how long marked scopes take, so that hitches can be traced back
+//! to what caused them.
+//!
+//! Every thread records into a ring buffer of its own, which only it writes
+//! to, so recording never takes a lock once a thread has its buffer. The
+//! main thread collects the buffers at the end of every frame, and keeps
+//! the last `HISTORY` frames for the overlay and for trace dumps.
+class Profiler : public Singleton<Profiler>
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    //! A scope which has finished.
+    struct Event {
+        //! Must outlive the profiler, e.g. a string literal.
+        const char* name;
+        //! Tells apart uses of the same scope, such as the opcodes of
+        //! packets, or -1.
+        std::int32_t arg;
+        std::uint32_t thread;
+        //! Nanoseconds since the profiler was created.
+        std::int64_t start;
+        //! In nanoseconds.
+        std::int64_t duration;
+    };
+
+    //! Times a scope, from construction to destruction.
+    class Scope
+    {
+    public:
+        explicit Scope(const char* n, std::int32_t a = -1) noexcept
+            : name{n}, arg{a}, start{clock::now()}
+        {
+        }
+
+        ~Scope()
+        {
+            Profiler::get().record(name, arg, start, clock::now());
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        const char* name;
+        std::int32_t arg;
+        clock::time_point start;
+    };
+
+    //! A frame which has finished, with the scopes recorded during it.
+    struct Frame {
+        //! All in nanoseconds, like the times of events.
+        std::int64_t start = 0;
+        std::int64_t duration = 0;
+        //! The part of the duration spent waiting for the next frame to be
+        //! due, rather than working.
+        std::int64_t idle = 0;
+        std::vector<Event> events;
+    };
+
+    //! The time spent in a scope per frame, over the recent frames.
+    struct Summary {
+        const char* name;
+        std::int32_t arg;
+        std::int64_t average;
+        std::int64_t worst;
+        std::uint32_t calls;
+    };
+
+    static constexpr const std::size_t HISTORY = 240;
+
+    Profiler() noexcept;
+
+    //! Start timing the first frame.
+    void start() noexcept;
+    //! Record a scope which has finished, on the calling thread. Dropped if
+    //! the buffer of the thread is full.
+    void record(const char* name,
+                std::int32_t arg,
+                clock::time_point start,
+                clock::time_point end) noexcept;
+    //! Collect the scopes recorded by all threads, and start a new frame.
+    //! `idle` is how long the frame waited for the frame rate limit. Must be
+    //! called by the main thread.
+    void end_frame(clock::duration idle = clock::duration::zero());
+
+    //! Return the last frame which has finished.
+    const Frame& last_frame() const noexcept;
+    //! Return the durations of the recent frames in nanoseconds, oldest
+    //! first.
+    std::vector<std::int64_t> frame_times() const;
+    //! Return the `count` scopes which took the most time per frame, over
+    //! the recent frames. Time spent in nested scopes is included.
+    std::vector<Summary> top_scopes(std::size_t count) const;
+    //! Write the recent frames to a file, in the trace event format which
+    //! Chrome's tracing view reads. Returns `false` if the file could not be
+    //! written.
+    bool dump_trace(const std::string& path) const;
+
+    void toggle_overlay() noexcept;
+    bool overlay_enabled() const noexcept;
+
+private:
+    static constexpr const std::size_t RING_SIZE = 4096;
+
+    //! Events recorded by one thread, waiting to be collected.
+    struct Ring {
+        std::array<Event, RING_SIZE> events;
+        //! Only written by the recording thread.
+        std::atomic<std::size_t> head{0};
+        //! Only written by the collecting thread.
+        std::atomic<std::size_t> tail{0};
+        //! Whether a thread owns the ring. Rings of threads which have
+        //! exited are reused.
+        std::atomic<bool> owned{true};
+        std::uint32_t thread = 0;
+    };
+
+    //! Releases the ring of a thread when the thread exits.
+    struct RingOwner {
+        Ring* ring = nullptr;
+
+        ~RingOwner();
+    };
+
+    //! Return the ring of the calling thread, taking one if it has none.
+    Ring& thread_ring();
+    std::int64_t since_start(clock::time_point time) const noexcept;
+    static std::int64_t nanoseconds(clock::duration duration) noexcept;
+
+    clock::time_point epoch;
+    clock::time_point frame_start;
+
+    std::mutex ring_mutex;
+    std::vector<std::unique_ptr<Ring>> rings;
+    std::uint32_t next_thread;
+    std::atomic<std::uint64_t> dropped;
+
+    //! The recent frames, used as a ring buffer. The frame being recorded
+    //! is at `current`.
+    std::vector<Frame> frames;
+    std::size_t current;
+    std::size_t frame_count;
+
+    bool overlay;
+};
+} // namespace jrc
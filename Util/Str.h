@@ -6,6 +6,7 @@
 
 #include <cstdio>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
 
@@ -82,4 +83,58 @@ template<typename... Args>
     ((s += std::forward<Args>(args)), ...);
     return s;
 }
+
+//! Decode the UTF-8 sequence starting at `pos`, and move `pos` past it.
+//! Malformed sequences decode to U+FFFD, one byte at a time.
+[[nodiscard]] inline char32_t next_codepoint(std::string_view text,
+                                             std::size_t& pos) noexcept
+{
+    constexpr const char32_t REPLACEMENT = 0xFFFD;
+
+    auto lead = static_cast<unsigned char>(text[pos++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    std::size_t length;
+    char32_t codepoint;
+    char32_t min;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 1;
+        codepoint = lead & 0x1F;
+        min = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 2;
+        codepoint = lead & 0x0F;
+        min = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 3;
+        codepoint = lead & 0x07;
+        min = 0x10000;
+    } else {
+        return REPLACEMENT;
+    }
+
+    if (text.size() - pos < length) {
+        return REPLACEMENT;
+    }
+
+    for (std::size_t i = 0; i < length; ++i) {
+        auto next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            return REPLACEMENT;
+        }
+
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+
+    // Overlong encodings and surrogates are not valid UTF-8.
+    if (codepoint < min || codepoint > 0x10FFFF
+        || (codepoint >= 0xD800 && codepoint <= 0xDFFF)) {
+        return REPLACEMENT;
+    }
+
+    pos += length;
+    return codepoint;
+}
 } // namespace jrc::str